@@ -2,17 +2,6 @@
 #include "Configuration.h"
 
 namespace configuration {
-	const int POLYPHONY = 16; // 16
-	const int OSC_NUMBER = 3; // 3
-	const int FILTER_NUMBER = 2; // 2
-	const int FX_NUMBER = 2; // 2
-	const int ENV_NUMBER = 3; // 3
-	const int LFO_NUMBER = 3; // 3
-
-	const int MOD_BLOCK_SIZE = 128;
-
-	const int EMPTY_MOD_CHANNEL = ENV_NUMBER + LFO_NUMBER;
-
 	const juce::StringArray& getModChannelNames() {
 		static juce::StringArray array;
 		if (!array.isEmpty()) {
@@ -45,6 +34,7 @@ namespace configuration {
 	const juce::String WF1_SUFFIX{"::WF1"};
 	const juce::String WT_SUFFIX{"::WT"};
 	const juce::String PITCH_SUFFIX{"::PITCH"};
+	const juce::String INTERPOLATION_SUFFIX{"::INTERPOLATION"};
 	const juce::String GAIN_SUFFIX{"::GAIN"};
 	const juce::String ATTACK_SUFFIX{"::ATTACK"};
 	const juce::String DECAY_SUFFIX{"::DECAY"};
@@ -63,6 +53,8 @@ namespace configuration {
 	const juce::String PARAMETER_1_SUFFIX{ "::PARAMETER_1" };
 	const juce::String PARAMETER_2_SUFFIX{ "::PARAMETER_2" };
 	const juce::String PAN_SUFFIX{"::PAN"};
+	const juce::String GLOBAL_FX_SUFFIX{"::GLOBAL_FX"};
+	const juce::String GLOBAL_SUFFIX{"::GLOBAL"};
 
 	const juce::String VALUE_TREE_IDENTIFIER{"Parameters"};
 
@@ -70,7 +62,7 @@ namespace configuration {
 
 	const juce::String WT_FOLDER_NAME{"wavetables"};
 	const juce::String WT_FILE_EXTENSION{".wt"};
-	extern const int MAX_TABLES_IN_MEM{2};
+	extern const size_t WT_CACHE_BUDGET_BYTES{64 * 1024 * 1024};
 
 	const juce::String PRESET_FOLDER_NAME{"presets"};
 
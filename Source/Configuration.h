@@ -2,17 +2,38 @@
 #pragma once
 #include <JuceHeader.h>
 
+// the engine dimensions are fixed at compile time, so loops over voices, modules and sub blocks get sized
+// statically. a build profile can override them through these defines, e.g. more voices for offline rendering
+#ifndef SYNTH_POLYPHONY
+#define SYNTH_POLYPHONY 16
+#endif
+#ifndef SYNTH_MOD_BLOCK_SIZE
+#define SYNTH_MOD_BLOCK_SIZE 128
+#endif
+#ifndef SYNTH_CONTROL_BLOCK_SIZE
+#define SYNTH_CONTROL_BLOCK_SIZE 16
+#endif
+
 namespace configuration {
-	extern const int POLYPHONY;
-	extern const int OSC_NUMBER;
-	extern const int FILTER_NUMBER;
-	extern const int FX_NUMBER;
-	extern const int ENV_NUMBER;
-	extern const int LFO_NUMBER;
+	constexpr int POLYPHONY = SYNTH_POLYPHONY;
+	constexpr int OSC_NUMBER = 3;
+	constexpr int FILTER_NUMBER = 2;
+	constexpr int FX_NUMBER = 2;
+	constexpr int ENV_NUMBER = 3;
+	constexpr int LFO_NUMBER = 3;
+
+	constexpr int MOD_BLOCK_SIZE = SYNTH_MOD_BLOCK_SIZE;
+	// samples between two control points of a modulation destination, see customDsp::ControlRamp.
+	// a power of two from 8 to MOD_BLOCK_SIZE
+	constexpr int CONTROL_BLOCK_SIZE = SYNTH_CONTROL_BLOCK_SIZE;
 
-	extern const int MOD_BLOCK_SIZE;
+	constexpr int EMPTY_MOD_CHANNEL = ENV_NUMBER + LFO_NUMBER;
 
-	extern const int EMPTY_MOD_CHANNEL;
+	static_assert(POLYPHONY > 0);
+	static_assert(8 <= CONTROL_BLOCK_SIZE && CONTROL_BLOCK_SIZE <= MOD_BLOCK_SIZE
+		&& (CONTROL_BLOCK_SIZE & (CONTROL_BLOCK_SIZE - 1)) == 0);
+	// mod channels, including the empty one, are tracked in 32 bit masks
+	static_assert(EMPTY_MOD_CHANNEL < 32);
 
 	const juce::StringArray& getModChannelNames();
 
@@ -33,6 +54,7 @@ namespace configuration {
 	extern const juce::String WF1_SUFFIX;
 	extern const juce::String WT_SUFFIX;
 	extern const juce::String PITCH_SUFFIX;
+	extern const juce::String INTERPOLATION_SUFFIX;
 	extern const juce::String GAIN_SUFFIX;
 	extern const juce::String ATTACK_SUFFIX;
 	extern const juce::String DECAY_SUFFIX;
@@ -51,6 +73,38 @@ namespace configuration {
 	extern const juce::String PARAMETER_1_SUFFIX;
 	extern const juce::String PARAMETER_2_SUFFIX;
 	extern const juce::String PAN_SUFFIX;
+	extern const juce::String GLOBAL_FX_SUFFIX;
+	extern const juce::String GLOBAL_SUFFIX;
+
+	// stable index for every parameter suffix. parameter changes are dispatched with these,
+	// so a listener can tell its parameters apart without comparing ids
+	enum class ParamSuffix {
+		BYPASSED,
+		MOD_CHANNEL,
+		MOD_FACTOR,
+		WT_POS,
+		WT,
+		PITCH,
+		GAIN,
+		ATTACK,
+		DECAY,
+		SUSTAIN,
+		RELEASE,
+		RATE,
+		CUTOFF,
+		RESONANCE,
+		SPECIAL,
+		FILTER_TYPE,
+		FX_TYPE,
+		DRY_WET,
+		PARAMETER_0,
+		PARAMETER_1,
+		PARAMETER_2,
+		PAN,
+		GLOBAL_FX,
+		GLOBAL,
+		INTERPOLATION,
+	};
 
 	extern const juce::String VALUE_TREE_IDENTIFIER;
 
@@ -58,7 +112,8 @@ namespace configuration {
 
 	extern const juce::String WT_FOLDER_NAME;
 	extern const juce::String WT_FILE_EXTENSION;
-	extern const int MAX_TABLES_IN_MEM;
+	// default memory budget of the wavetable cache
+	extern const size_t WT_CACHE_BUDGET_BYTES;
 
 	extern const juce::String PRESET_FOLDER_NAME;
 
@@ -30,20 +30,16 @@ namespace customDsp {
 			src_channel));
 	}
 
-	void ModulationParam::registerAsListener(juce::AudioProcessorValueTreeState& apvts, const juce::String& name) {
-		apvts.addParameterListener(name + configuration::MOD_CHANNEL_SUFFIX, this);
-		apvts.addParameterListener(name + configuration::MOD_FACTOR_SUFFIX, this);
+	void ModulationParam::registerAsListener(ParameterSnapshot& parameters, const juce::String& name) {
+		parameters.addParameterListener(name + configuration::MOD_CHANNEL_SUFFIX, configuration::ParamSuffix::MOD_CHANNEL, this);
+		parameters.addParameterListener(name + configuration::MOD_FACTOR_SUFFIX, configuration::ParamSuffix::MOD_FACTOR, this);
 	}
 
-	void ModulationParam::parameterChanged(const juce::String& parameterID, float newValue) {
-		if (parameterID.endsWith(configuration::MOD_CHANNEL_SUFFIX)) {
-			src_channel = (int)newValue;
-		}
-		else if (parameterID.endsWith(configuration::MOD_FACTOR_SUFFIX)) {
-			factor = newValue;
-		}
-		else {
-			jassertfalse;
+	void ModulationParam::parameterChanged(configuration::ParamSuffix suffix, float newValue) {
+		switch (suffix) {
+		case configuration::ParamSuffix::MOD_CHANNEL: src_channel = (int)newValue; break;
+		case configuration::ParamSuffix::MOD_FACTOR: factor = newValue; break;
+		default: jassertfalse; break;
 		}
 	}
 
@@ -55,6 +51,93 @@ namespace customDsp {
 		isNoteOn = false;
 	}
 
+	ControlRamp::ControlRamp(int t_controlBlockSize) : controlBlockSize(t_controlBlockSize) {
+		jassert(8 <= controlBlockSize && controlBlockSize <= configuration::MOD_BLOCK_SIZE && juce::isPowerOfTwo(controlBlockSize));
+	}
+
+	void ControlRamp::reset() {
+		isFirst = true;
+	}
+
+	void ControlRamp::fill(float* dest, int numSamples, float start, float increment) {
+		write<false>(dest, numSamples, start, increment);
+	}
+
+	void ControlRamp::add(float* dest, int numSamples, float start, float increment) {
+		write<true>(dest, numSamples, start, increment);
+	}
+
+	template <bool addToDest>
+	void ControlRamp::write(float* dest, int numSamples, float start, float increment) {
+		using Vec = juce::dsp::SIMDRegister<float>;
+		constexpr int N = (int)Vec::SIMDNumElements;
+
+		// scalar up to the first aligned sample, SIMD registers from there and scalar again for the rest
+		int i = 0;
+		auto head = juce::jmin(numSamples, (int)(Vec::getNextSIMDAlignedPtr(dest) - dest));
+		for (; i < head; i++) {
+			dest[i] = (addToDest ? dest[i] : 0.f) + start + (float)i * increment;
+		}
+		if (i + N <= numSamples) {
+			alignas(sizeof(Vec)) float indices[N];
+			for (int k = 0; k < N; k++) {
+				indices[k] = (float)(i + k);
+			}
+			auto index = Vec::fromRawArray(indices);
+			const auto stride = Vec::expand((float)N);
+			const auto startVec = Vec::expand(start);
+			const auto incrementVec = Vec::expand(increment);
+			for (; i + N <= numSamples; i += N) {
+				auto value = startVec + index * incrementVec;
+				if constexpr (addToDest) {
+					value += Vec::fromRawArray(dest + i);
+				}
+				value.copyToRawArray(dest + i);
+				index += stride;
+			}
+		}
+		for (; i < numSamples; i++) {
+			dest[i] = (addToDest ? dest[i] : 0.f) + start + (float)i * increment;
+		}
+	}
+
+	void Crossfade::prepare(const juce::dsp::ProcessSpec& spec, double fadeTimeSec) {
+		buffer.setSize((int)spec.numChannels, (int)spec.maximumBlockSize);
+		fadeSamples = juce::jmax(1, static_cast<int>(fadeTimeSec * spec.sampleRate));
+		remainingSamples = 0;
+	}
+
+	void Crossfade::start() {
+		remainingSamples = fadeSamples;
+	}
+
+	bool Crossfade::isActive() const {
+		return remainingSamples > 0;
+	}
+
+	juce::dsp::AudioBlock<float> Crossfade::copyForOldSignal(const juce::dsp::AudioBlock<float>& block) {
+		jassert(block.getNumChannels() <= (size_t)buffer.getNumChannels());
+		jassert(block.getNumSamples() <= (size_t)buffer.getNumSamples());
+		auto oldSignal = juce::dsp::AudioBlock<float>{ buffer }
+			.getSubsetChannelBlock(0, block.getNumChannels())
+			.getSubBlock(0, block.getNumSamples());
+		oldSignal.copyFrom(block);
+		return oldSignal;
+	}
+
+	void Crossfade::apply(juce::dsp::AudioBlock<float>& newSignal) {
+		auto samplesToFade = juce::jmin(remainingSamples, (int)newSignal.getNumSamples());
+		for (size_t channel = 0; channel < newSignal.getNumChannels(); channel++) {
+			auto* newPtr = newSignal.getChannelPointer(channel);
+			auto* oldPtr = buffer.getReadPointer((int)channel);
+			for (int i = 0; i < samplesToFade; i++) {
+				auto oldGain = (remainingSamples - i) / static_cast<float>(fadeSamples);
+				newPtr[i] += oldGain * (oldPtr[i] - newPtr[i]);
+			}
+		}
+		remainingSamples -= samplesToFade;
+	}
+
 	void ProcessorChain::prepare(const juce::dsp::ProcessSpec& spec) {
 		std::for_each(processors.begin(), processors.end(), [&](Processor* p) {p->prepare(spec); });
 	};
@@ -97,6 +180,9 @@ namespace customDsp {
 		jassert(processors.size() < context.getOutputBlock().getNumChannels());
 		bool needMoreTime = false;
 		for (int i = 0; i < processors.size(); i++) {
+			if (!isProcessorActive(i)) {
+				continue;
+			}
 			auto singleOutputChannel = context.getOutputBlock().getSingleChannelBlock(i);
 			juce::dsp::ProcessContextNonReplacing<float> tmp_context{ context.getInputBlock(), singleOutputChannel };
 			needMoreTime |= processors[i]->process(tmp_context, workBuffers);
@@ -104,6 +190,14 @@ namespace customDsp {
 		return needMoreTime;
 	};
 
+	void SplitProcessor::setActiveProcessors(juce::uint32 mask) {
+		activeProcessors = mask;
+	}
+
+	bool SplitProcessor::isProcessorActive(int index) const {
+		return (activeProcessors >> index) & 1u;
+	}
+
 	InterpolationOsc* InterpolationOsc::SharedData::createProcessor() {
 		return new InterpolationOsc(this);
 	};
@@ -131,6 +225,12 @@ namespace customDsp {
 			pitch));
 		modParams[PITCH].addModParams(layout, prefix + configuration::PITCH_SUFFIX, 24.f, 0.01f);
 
+		layout.add(std::make_unique<juce::AudioParameterChoice>(
+			prefix + configuration::INTERPOLATION_SUFFIX,
+			prefix + configuration::INTERPOLATION_SUFFIX,
+			INTERPOLATION_QUALITY_NAMES,
+			(int)quality));
+
 		layout.add(std::make_unique<juce::AudioParameterChoice>(
 			prefix + configuration::WT_SUFFIX,
 			prefix + configuration::WT_SUFFIX,
@@ -138,36 +238,32 @@ namespace customDsp {
 			0));
 	}
 
-	void InterpolationOsc::SharedData::registerAsListener(juce::AudioProcessorValueTreeState& apvts) {
-		apvts.addParameterListener(prefix + configuration::BYPASSED_SUFFIX, this);
-		modParams[ENV].registerAsListener(apvts, prefix + configuration::ENV_SUFFIX);
-		apvts.addParameterListener(prefix + configuration::WT_POS_SUFFIX, this);
-		modParams[WT_POS].registerAsListener(apvts, prefix + configuration::WT_POS_SUFFIX);
-		apvts.addParameterListener(prefix + configuration::PITCH_SUFFIX, this);
-		modParams[PITCH].registerAsListener(apvts, prefix + configuration::PITCH_SUFFIX);
-		apvts.addParameterListener(prefix + configuration::WT_SUFFIX, this);
+	void InterpolationOsc::SharedData::registerAsListener(ParameterSnapshot& parameters) {
+		parameters.addParameterListener(prefix + configuration::BYPASSED_SUFFIX, configuration::ParamSuffix::BYPASSED, this);
+		modParams[ENV].registerAsListener(parameters, prefix + configuration::ENV_SUFFIX);
+		parameters.addParameterListener(prefix + configuration::WT_POS_SUFFIX, configuration::ParamSuffix::WT_POS, this);
+		modParams[WT_POS].registerAsListener(parameters, prefix + configuration::WT_POS_SUFFIX);
+		parameters.addParameterListener(prefix + configuration::PITCH_SUFFIX, configuration::ParamSuffix::PITCH, this);
+		modParams[PITCH].registerAsListener(parameters, prefix + configuration::PITCH_SUFFIX);
+		parameters.addParameterListener(prefix + configuration::INTERPOLATION_SUFFIX, configuration::ParamSuffix::INTERPOLATION, this);
+		parameters.addParameterListener(prefix + configuration::WT_SUFFIX, configuration::ParamSuffix::WT, this);
+		parameters.addPublishListener(prefix + configuration::WT_SUFFIX, configuration::ParamSuffix::WT, &wtHandoff);
 	}
 
-	void InterpolationOsc::SharedData::parameterChanged(const juce::String& parameterID, float newValue) {
-		if (parameterID.endsWith(configuration::BYPASSED_SUFFIX)) {
-			bypassed = (bool)newValue;
-		}
-		else if (parameterID.endsWith(configuration::WT_POS_SUFFIX)) {
-			wtPos = newValue;
-		}
-		else if (parameterID.endsWith(configuration::PITCH_SUFFIX)) {
-			pitch = newValue;
-		}
-		else if (parameterID.endsWith(configuration::WT_SUFFIX)) {
-			wt = wavetable::WavetableCache::getInstance()->getWavetable(static_cast<int>(newValue));
-		}
-		else {
-			jassertfalse;
+	void InterpolationOsc::SharedData::parameterChanged(configuration::ParamSuffix suffix, float newValue) {
+		switch (suffix) {
+		case configuration::ParamSuffix::BYPASSED: bypassed = (bool)newValue; break;
+		case configuration::ParamSuffix::WT_POS: wtPos = newValue; break;
+		case configuration::ParamSuffix::PITCH: pitch = newValue; break;
+		case configuration::ParamSuffix::INTERPOLATION: quality = static_cast<InterpolationQuality>((int)newValue); break;
+		case configuration::ParamSuffix::WT: wtHandoff.collect(wt); break;
+		default: jassertfalse; break;
 		}
 	}
 
 	void InterpolationOsc::prepare(const juce::dsp::ProcessSpec& spec) {
 		data->sampleRate = spec.sampleRate;
+		data->wtHandoff.setSampleRate(spec.sampleRate);
 	};
 
 	void InterpolationOsc::reset() {
@@ -178,13 +274,19 @@ namespace customDsp {
 
 	bool InterpolationOsc::process(juce::dsp::ProcessContextNonReplacing<float>& context, juce::dsp::AudioBlock<float>& workBuffers)
 	{
-		if (data->bypassed || context.isBypassed) {
+		if (context.isBypassed || !isProducingOutput()) {
 			return false;
 		}
-
-		if (!data->modParams[SharedData::ENV].isActive() && !isNoteOn && !shouldStopCleanly) {
-			return false;
+		switch (data->quality) {
+		case InterpolationQuality::HERMITE: return processWith<HermiteKernel>(context, workBuffers);
+		case InterpolationQuality::LAGRANGE: return processWith<LagrangeKernel>(context, workBuffers);
+		default: return processWith<LinearKernel>(context, workBuffers);
 		}
+	}
+
+	template <typename Kernel>
+	bool InterpolationOsc::processWith(juce::dsp::ProcessContextNonReplacing<float>& context, juce::dsp::AudioBlock<float>& workBuffers)
+	{
 		auto& inputBlock = context.getInputBlock(); // holds envelopes and lfos for modulation
 		auto& outputBlock = context.getOutputBlock();
 
@@ -207,15 +309,17 @@ namespace customDsp {
 
 		// disregard pitch modulation when considering harmonics
 		auto& wt = data->wt->getTable(frequency * std::exp2f((basePitch + pitchMod * pitchModSrc[0]) / 12.f));
+		// velocity and a multiplier so that more than one voice without reaching 0dB, finishBlock adds the envelope
+		const auto multiplier = velocity / configuration::OSC_NUMBER;
 
-		for (int start = 0; start < workBuffers.getNumSamples(); start += configuration::MOD_BLOCK_SIZE) {
+		for (int start = 0; start < workBuffers.getNumSamples(); start += configuration::CONTROL_BLOCK_SIZE) {
 
-			auto end = juce::jmin(start + configuration::MOD_BLOCK_SIZE, (int)workBuffers.getNumSamples());
+			auto end = juce::jmin(start + configuration::CONTROL_BLOCK_SIZE, (int)workBuffers.getNumSamples());
 
-			// calculate modulated arguments for the next ~MOD_BLOCK_SIZE samples
+			// calculate modulated arguments for the next ~CONTROL_BLOCK_SIZE samples
 			auto pitch = basePitch + pitchMod * pitchModSrc[start];
 			auto actualFrequency = (frequency * std::exp2f(pitch / 12.f));
-			float phaseStep = (juce::MathConstants<float>::twoPi * actualFrequency) / (float)data->sampleRate;
+			auto phaseIncrement = PhaseAccumulator::getIncrement(actualFrequency, data->sampleRate);
 			auto wtPos = juce::jlimit(0.f, 1.f, baseWtPos + wtPosMod * wtPosModSrc[start]);
 
 			auto scaledWtPos = wtPos * (wt.getNumChannels() - 1 - 1);
@@ -224,28 +328,218 @@ namespace customDsp {
 
 			auto channel0 = wt.getReadPointer(channelIndex);
 			auto channel1 = wt.getReadPointer(channelIndex + 1);
+			const int resolution = wt.getNumSamples() - 1;
 
 			for (int i = start; i < end; i++) {
 
-				auto x = phase.advance(phaseStep);
+				auto x = phase.advance(phaseIncrement);
 
-				auto scaledX = (x / juce::MathConstants<float>::twoPi) * (wt.getNumSamples() - 1);
-				int sampleIndex = static_cast<int>(scaledX);
-				auto xDelta = scaledX - sampleIndex;
-				auto sample0 = juce::jmap(xDelta, channel0[sampleIndex], channel0[sampleIndex + 1]);
-				auto sample1 = juce::jmap(xDelta, channel1[sampleIndex], channel1[sampleIndex + 1]);
+				int sampleIndex = PhaseAccumulator::getIndex(x, resolution);
+				auto xDelta = PhaseAccumulator::getFraction(x, resolution);
+				float sample0, sample1;
+				if constexpr (Kernel::NUM_POINTS == 2) {
+					sample0 = Kernel::interpolate(0.f, channel0[sampleIndex], channel0[sampleIndex + 1], 0.f, xDelta);
+					sample1 = Kernel::interpolate(0.f, channel1[sampleIndex], channel1[sampleIndex + 1], 0.f, xDelta);
+				}
+				else {
+					auto before = wrapIndex(sampleIndex - 1, resolution);
+					auto after = wrapIndex(sampleIndex + 2, resolution);
+					sample0 = Kernel::interpolate(channel0[before], channel0[sampleIndex], channel0[sampleIndex + 1], channel0[after], xDelta);
+					sample1 = Kernel::interpolate(channel1[before], channel1[sampleIndex], channel1[sampleIndex + 1], channel1[after], xDelta);
+				}
 
-				auto sample = juce::jmap(channelDelta, sample0, sample1);
+				auto sample = juce::jmap(channelDelta, sample0, sample1) * multiplier;
 
 				// important to replace instead of add here
 				tmpPtr[i] = sample;
 			}
-			// apply envelope, velocity and a multiplier so that more than one voice without reaching 0dB
-			auto multiplier = data->modParams[SharedData::ENV].isActive() ?
-				inputBlock.getSample((size_t)data->modParams[SharedData::ENV].src_channel, start)
-				: 1.f;
-			multiplier *= velocity / configuration::OSC_NUMBER;
-			workBuffers.getSingleChannelBlock(0).getSubBlock(start, end - start).multiplyBy(multiplier);
+		}
+
+		return finishBlock(inputBlock, outputBlock, workBuffers);
+	}
+
+	void InterpolationOsc::processBatch(BatchItem* items, int numItems)
+	{
+		jassert(0 < numItems && numItems <= BATCH_SIZE);
+
+		// only oscillators which actually produce output get a lane
+		BatchItem* lanes[BATCH_SIZE];
+		int numLanes = 0;
+		for (int i = 0; i < numItems; i++) {
+			items[i].needMoreTime = false;
+			if (items[i].osc->isProducingOutput()) {
+				lanes[numLanes++] = &items[i];
+			}
+		}
+		if (numLanes == 0) {
+			return;
+		}
+
+		// usually all lanes share the quality, otherwise every quality gets a batch of its own
+		for (auto quality : { InterpolationQuality::LINEAR, InterpolationQuality::HERMITE, InterpolationQuality::LAGRANGE }) {
+			BatchItem* qualityLanes[BATCH_SIZE];
+			int numQualityLanes = 0;
+			for (int lane = 0; lane < numLanes; lane++) {
+				if (lanes[lane]->osc->data->quality == quality) {
+					qualityLanes[numQualityLanes++] = lanes[lane];
+				}
+			}
+			if (numQualityLanes == 0) {
+				continue;
+			}
+			// a single lane would leave the rest of the register idle, the scalar loop is faster there
+			if (numQualityLanes == 1) {
+				auto& item = *qualityLanes[0];
+				juce::dsp::ProcessContextNonReplacing<float> context{ item.inputBlock, item.outputBlock };
+				item.needMoreTime = item.osc->process(context, item.workBuffers);
+				continue;
+			}
+			switch (quality) {
+			case InterpolationQuality::HERMITE: processLanes<HermiteKernel>(qualityLanes, numQualityLanes); break;
+			case InterpolationQuality::LAGRANGE: processLanes<LagrangeKernel>(qualityLanes, numQualityLanes); break;
+			default: processLanes<LinearKernel>(qualityLanes, numQualityLanes); break;
+			}
+		}
+	}
+
+	template <typename Kernel>
+	void InterpolationOsc::processLanes(BatchItem** lanes, int numLanes)
+	{
+		using Vec = juce::dsp::SIMDRegister<float>;
+		// phases wrap by overflowing in their lanes just like in PhaseAccumulator
+		using PhaseVec = juce::dsp::SIMDRegister<juce::uint32>;
+		static_assert(PhaseVec::SIMDNumElements == Vec::SIMDNumElements);
+		jassert(0 < numLanes && numLanes <= BATCH_SIZE);
+		auto numSamples = (int)lanes[0]->workBuffers.getNumSamples();
+
+		// state of all lanes as structure of arrays; unused lanes just calculate silence
+		alignas(sizeof(PhaseVec)) juce::uint32 phases[BATCH_SIZE]{};
+		alignas(sizeof(PhaseVec)) juce::uint32 phaseIncrements[BATCH_SIZE]{};
+		alignas(sizeof(Vec)) float channelDeltas[BATCH_SIZE]{};
+		alignas(sizeof(Vec)) float multipliers[BATCH_SIZE]{};
+		alignas(sizeof(PhaseVec)) juce::uint32 xs[BATCH_SIZE]{};
+		alignas(sizeof(Vec)) float xDeltas[BATCH_SIZE]{};
+		// samplesCP holds point P (0 is the sample before, 3 the one after next) of channel C
+		alignas(sizeof(Vec)) float samples00[BATCH_SIZE]{};
+		alignas(sizeof(Vec)) float samples01[BATCH_SIZE]{};
+		alignas(sizeof(Vec)) float samples02[BATCH_SIZE]{};
+		alignas(sizeof(Vec)) float samples03[BATCH_SIZE]{};
+		alignas(sizeof(Vec)) float samples10[BATCH_SIZE]{};
+		alignas(sizeof(Vec)) float samples11[BATCH_SIZE]{};
+		alignas(sizeof(Vec)) float samples12[BATCH_SIZE]{};
+		alignas(sizeof(Vec)) float samples13[BATCH_SIZE]{};
+		alignas(sizeof(Vec)) float results[BATCH_SIZE]{};
+		int resolutions[BATCH_SIZE];
+		const juce::AudioBuffer<float>* tables[BATCH_SIZE];
+		const float* channels0[BATCH_SIZE];
+		const float* channels1[BATCH_SIZE];
+		float* outputs[BATCH_SIZE];
+
+		for (int lane = 0; lane < numLanes; lane++) {
+			auto* osc = lanes[lane]->osc;
+			auto pitchModSrc = lanes[lane]->inputBlock.getChannelPointer((size_t)osc->data->modParams[SharedData::PITCH].src_channel);
+
+			// disregard pitch modulation when considering harmonics
+			tables[lane] = &osc->data->wt->getTable(osc->frequency
+				* std::exp2f((osc->data->pitch + osc->data->modParams[SharedData::PITCH].factor * pitchModSrc[0]) / 12.f));
+			resolutions[lane] = tables[lane]->getNumSamples() - 1;
+			phases[lane] = osc->phase.value;
+			// velocity and a multiplier so that more than one voice without reaching 0dB, finishBlock adds the envelope
+			multipliers[lane] = osc->velocity / configuration::OSC_NUMBER;
+			outputs[lane] = lanes[lane]->workBuffers.getChannelPointer(0);
+		}
+
+		auto phase = PhaseVec::fromRawArray(phases);
+		const auto multiplier = Vec::fromRawArray(multipliers);
+
+		for (int start = 0; start < numSamples; start += configuration::CONTROL_BLOCK_SIZE) {
+
+			auto end = juce::jmin(start + configuration::CONTROL_BLOCK_SIZE, numSamples);
+
+			// calculate modulated arguments for the next ~CONTROL_BLOCK_SIZE samples, lane by lane
+			for (int lane = 0; lane < numLanes; lane++) {
+				auto* osc = lanes[lane]->osc;
+				auto* data = osc->data;
+				auto& inputBlock = lanes[lane]->inputBlock;
+				auto& wt = *tables[lane];
+
+				auto pitch = data->pitch + data->modParams[SharedData::PITCH].factor
+					* inputBlock.getSample(data->modParams[SharedData::PITCH].src_channel, start);
+				auto actualFrequency = (osc->frequency * std::exp2f(pitch / 12.f));
+				phaseIncrements[lane] = PhaseAccumulator::getIncrement(actualFrequency, data->sampleRate);
+
+				auto wtPos = juce::jlimit(0.f, 1.f, data->wtPos + data->modParams[SharedData::WT_POS].factor
+					* inputBlock.getSample(data->modParams[SharedData::WT_POS].src_channel, start));
+				auto scaledWtPos = wtPos * (wt.getNumChannels() - 1 - 1);
+				int channelIndex = static_cast<int>(scaledWtPos);
+				channelDeltas[lane] = scaledWtPos - channelIndex;
+				channels0[lane] = wt.getReadPointer(channelIndex);
+				channels1[lane] = wt.getReadPointer(channelIndex + 1);
+			}
+			const auto phaseIncrement = PhaseVec::fromRawArray(phaseIncrements);
+			const auto channelDelta = Vec::fromRawArray(channelDeltas);
+
+			for (int i = start; i < end; i++) {
+				phase.copyToRawArray(xs);
+				phase += phaseIncrement;
+
+				// the table lookups can't be vectorized, everything around them can
+				for (int lane = 0; lane < numLanes; lane++) {
+					int sampleIndex = PhaseAccumulator::getIndex(xs[lane], resolutions[lane]);
+					xDeltas[lane] = PhaseAccumulator::getFraction(xs[lane], resolutions[lane]);
+					samples01[lane] = channels0[lane][sampleIndex];
+					samples02[lane] = channels0[lane][sampleIndex + 1];
+					samples11[lane] = channels1[lane][sampleIndex];
+					samples12[lane] = channels1[lane][sampleIndex + 1];
+					if constexpr (Kernel::NUM_POINTS == 4) {
+						auto before = wrapIndex(sampleIndex - 1, resolutions[lane]);
+						auto after = wrapIndex(sampleIndex + 2, resolutions[lane]);
+						samples00[lane] = channels0[lane][before];
+						samples03[lane] = channels0[lane][after];
+						samples10[lane] = channels1[lane][before];
+						samples13[lane] = channels1[lane][after];
+					}
+				}
+
+				auto xDelta = Vec::fromRawArray(xDeltas);
+				auto sample0 = Kernel::interpolate(Vec::fromRawArray(samples00), Vec::fromRawArray(samples01),
+					Vec::fromRawArray(samples02), Vec::fromRawArray(samples03), xDelta);
+				auto sample1 = Kernel::interpolate(Vec::fromRawArray(samples10), Vec::fromRawArray(samples11),
+					Vec::fromRawArray(samples12), Vec::fromRawArray(samples13), xDelta);
+				auto sample = (sample0 + channelDelta * (sample1 - sample0)) * multiplier;
+
+				// important to replace instead of add here
+				sample.copyToRawArray(results);
+				for (int lane = 0; lane < numLanes; lane++) {
+					outputs[lane][i] = results[lane];
+				}
+			}
+		}
+
+		phase.copyToRawArray(phases);
+		for (int lane = 0; lane < numLanes; lane++) {
+			auto* item = lanes[lane];
+			item->osc->phase.value = phases[lane];
+			item->needMoreTime = item->osc->finishBlock(item->inputBlock, item->outputBlock, item->workBuffers);
+		}
+	}
+
+	bool InterpolationOsc::isProducingOutput()
+	{
+		if (data->bypassed) {
+			return false;
+		}
+		return data->modParams[SharedData::ENV].isActive() || isNoteOn || shouldStopCleanly;
+	}
+
+	bool InterpolationOsc::finishBlock(const juce::dsp::AudioBlock<const float>& inputBlock,
+		juce::dsp::AudioBlock<float>& outputBlock, juce::dsp::AudioBlock<float>& workBuffers)
+	{
+		// the envelope is a ramp already, so following it sample by sample costs one multiplication
+		if (data->modParams[SharedData::ENV].isActive()) {
+			juce::FloatVectorOperations::multiply(workBuffers.getChannelPointer(0),
+				inputBlock.getChannelPointer((size_t)data->modParams[SharedData::ENV].src_channel),
+				(int)workBuffers.getNumSamples());
 		}
 
 		// prevent clicking when stopping without an envelope
@@ -309,17 +603,15 @@ namespace customDsp {
 		modParams[GAIN].addModParams(layout, prefix + configuration::GAIN_SUFFIX);
 	}
 
-	void Gain::SharedData::registerAsListener(juce::AudioProcessorValueTreeState& apvts) {
-		apvts.addParameterListener(prefix + configuration::GAIN_SUFFIX, this);
-		modParams[GAIN].registerAsListener(apvts, prefix + configuration::GAIN_SUFFIX);
+	void Gain::SharedData::registerAsListener(ParameterSnapshot& parameters) {
+		parameters.addParameterListener(prefix + configuration::GAIN_SUFFIX, configuration::ParamSuffix::GAIN, this);
+		modParams[GAIN].registerAsListener(parameters, prefix + configuration::GAIN_SUFFIX);
 	}
 
-	void Gain::SharedData::parameterChanged(const juce::String& parameterID, float newValue) {
-		if (parameterID.endsWith(configuration::GAIN_SUFFIX)) {
-			gain = newValue;
-		}
-		else {
-			jassertfalse;
+	void Gain::SharedData::parameterChanged(configuration::ParamSuffix suffix, float newValue) {
+		switch (suffix) {
+		case configuration::ParamSuffix::GAIN: gain = newValue; break;
+		default: jassertfalse; break;
 		}
 	}
 
@@ -328,7 +620,7 @@ namespace customDsp {
 	};
 
 	void Gain::reset() {
-		gainSmoothed.setCurrentAndTargetValue(data->gain);
+		gainRamp.reset();
 	}
 
 	bool Gain::process(juce::dsp::ProcessContextNonReplacing<float>& context, juce::dsp::AudioBlock<float>& workBuffers)
@@ -345,17 +637,9 @@ namespace customDsp {
 		auto gainMod = data->modParams[SharedData::GAIN].factor;
 		auto gainModSrc = inputBlock.getChannelPointer((size_t)data->modParams[SharedData::GAIN].src_channel);
 
-		auto workPtr = workBuffers.getChannelPointer(0);
-		for (int start = 0; start < workBuffers.getNumSamples(); start += configuration::MOD_BLOCK_SIZE) {
-			auto end = juce::jmin(start + configuration::MOD_BLOCK_SIZE, (int)workBuffers.getNumSamples());
-
-			gainSmoothed.reset(end - start);
-			gainSmoothed.setTargetValue(juce::jlimit(0.f, 1.f, baseGain + gainMod * gainModSrc[end-1]));
-
-			for (int i = start; i < end; i++) {
-				workPtr[i] = gainSmoothed.getNextValue();
-			}
-		}
+		gainRamp.process(workBuffers.getChannelPointer(0), (int)workBuffers.getNumSamples(), [&](int i) {
+			return juce::jlimit(0.f, 1.f, baseGain + gainMod * gainModSrc[i]);
+			});
 
 		for (size_t channel = 0; channel < outputBlock.getNumChannels(); channel++) {
 			outputBlock.getSingleChannelBlock(channel).multiplyBy(workBuffers.getSingleChannelBlock(0));
@@ -377,17 +661,15 @@ namespace customDsp {
 		modParams[PAN].addModParams(layout, prefix + configuration::PAN_SUFFIX);
 	}
 
-	void Pan::SharedData::registerAsListener(juce::AudioProcessorValueTreeState& apvts) {
-		apvts.addParameterListener(prefix + configuration::PAN_SUFFIX, this);
-		modParams[PAN].registerAsListener(apvts, prefix + configuration::PAN_SUFFIX);
+	void Pan::SharedData::registerAsListener(ParameterSnapshot& parameters) {
+		parameters.addParameterListener(prefix + configuration::PAN_SUFFIX, configuration::ParamSuffix::PAN, this);
+		modParams[PAN].registerAsListener(parameters, prefix + configuration::PAN_SUFFIX);
 	}
 
-	void Pan::SharedData::parameterChanged(const juce::String& parameterID, float newValue) {
-		if (parameterID.endsWith(configuration::PAN_SUFFIX)) {
-			pan = newValue;
-		}
-		else {
-			jassertfalse;
+	void Pan::SharedData::parameterChanged(configuration::ParamSuffix suffix, float newValue) {
+		switch (suffix) {
+		case configuration::ParamSuffix::PAN: pan = newValue; break;
+		default: jassertfalse; break;
 		}
 	}
 
@@ -395,6 +677,10 @@ namespace customDsp {
 		data->sampleRate = spec.sampleRate;
 	};
 
+	void Pan::reset() {
+		panRamp.reset();
+	}
+
 	bool Pan::process(juce::dsp::ProcessContextNonReplacing<float>& context, juce::dsp::AudioBlock<float>& workBuffers)
 	{
 		if (context.isBypassed) {
@@ -414,14 +700,17 @@ namespace customDsp {
 		auto panMod = data->modParams[SharedData::PAN].factor;
 		auto panModSrc = inputBlock.getChannelPointer((size_t)data->modParams[SharedData::PAN].src_channel);
 
-		for (int start = 0; start < workBuffers.getNumSamples(); start += configuration::MOD_BLOCK_SIZE) {
-
-			auto end = juce::jmin(start + configuration::MOD_BLOCK_SIZE, (int)workBuffers.getNumSamples());
-
-			auto currentPan = juce::jlimit(-1.f, 1.f, basePan + panMod * panModSrc[start]);
+		auto numSamples = (int)outputBlock.getNumSamples();
+		auto* panPtr = workBuffers.getChannelPointer(0);
+		panRamp.process(panPtr, numSamples, [&](int i) {
+			return juce::jlimit(-1.f, 1.f, basePan + panMod * panModSrc[i]);
+			});
 
-			left.getSubBlock(start, end - start).multiplyBy(1.f - currentPan);
-			right.getSubBlock(start, end - start).multiplyBy(1.f + currentPan);
+		auto* leftPtr = left.getChannelPointer(0);
+		auto* rightPtr = right.getChannelPointer(0);
+		for (int i = 0; i < numSamples; i++) {
+			leftPtr[i] *= 1.f - panPtr[i];
+			rightPtr[i] *= 1.f + panPtr[i];
 		}
 
 		return false;
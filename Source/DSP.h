@@ -1,16 +1,18 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include <tuple>
 #include "Configuration.h"
 #include "Wavetable.h"
+#include "ParameterSnapshot.h"
 
 namespace customDsp {
 
 	// number of channels to append to the outputBlock which can be freely used by processors to store
 	// temporary data
-	constexpr int WORK_BUFFERS = 2;
+	constexpr int WORK_BUFFERS = 3;
 
-	struct ModulationParam : public juce::AudioProcessorValueTreeState::Listener {
+	struct ModulationParam : public ParameterSnapshot::Listener {
 
 		float factor = 0.f;
 		int src_channel = configuration::EMPTY_MOD_CHANNEL;
@@ -24,16 +26,16 @@ namespace customDsp {
 		void addModParams(juce::AudioProcessorValueTreeState::ParameterLayout& layout, const juce::String& name,
 			float modRange = 1.f, float intervalValue = 0.001f);
 
-		void registerAsListener(juce::AudioProcessorValueTreeState& apvts, const juce::String& name);
+		void registerAsListener(ParameterSnapshot& parameters, const juce::String& name);
 
-		virtual void parameterChanged(const juce::String& parameterID, float newValue) override;
+		virtual void parameterChanged(configuration::ParamSuffix suffix, float newValue) override;
 	};
 
 
 	class Processor {
 	public:
 
-		struct SharedData : public juce::AudioProcessorValueTreeState::Listener {
+		struct SharedData : public ParameterSnapshot::Listener {
 			double sampleRate{ 0.f };
 			juce::String prefix;
 
@@ -41,7 +43,8 @@ namespace customDsp {
 			SharedData(const juce::String& t_prefix) : prefix(t_prefix) {};
 			virtual ~SharedData() {};
 			virtual void addParams(juce::AudioProcessorValueTreeState::ParameterLayout& layout) = 0;
-			virtual void registerAsListener(juce::AudioProcessorValueTreeState& apvts) = 0;
+			// parameterChanged gets called on the audio thread, between blocks
+			virtual void registerAsListener(ParameterSnapshot& parameters) = 0;
 			virtual Processor* createProcessor() = 0;
 
 		private:
@@ -73,6 +76,113 @@ namespace customDsp {
 		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Processor)
 	};
 
+	// Phase of a periodic signal as an unsigned 32 bit fraction of a cycle. It wraps by overflowing, so it stays
+	// exact no matter how long a note is held, and getting a table position from it needs no float division.
+	struct PhaseAccumulator {
+		juce::uint32 value = 0;
+
+		void reset() {
+			value = 0;
+		}
+
+		// returns the phase before advancing
+		juce::uint32 advance(juce::uint32 increment) {
+			auto current = value;
+			value += increment;
+			return current;
+		}
+
+		// only the fractional part of cycles matters
+		static juce::uint32 fromCycles(double cycles) {
+			cycles -= std::floor(cycles);
+			return static_cast<juce::uint32>(static_cast<juce::uint64>(cycles * 4294967296.0));
+		}
+
+		static juce::uint32 getIncrement(double frequency, double sampleRate) {
+			jassert(sampleRate > 0.0);
+			return fromCycles(frequency / sampleRate);
+		}
+
+		// the sample of a cycle with resolution samples at phase, for powers of two just the top bits of phase
+		static int getIndex(juce::uint32 phase, int resolution) {
+			return static_cast<int>(((juce::uint64)phase * (juce::uint64)resolution) >> 32);
+		}
+
+		// how far phase is between getIndex and the next sample, from the bits below the index
+		static float getFraction(juce::uint32 phase, int resolution) {
+			auto belowIndex = static_cast<juce::uint32>((juce::uint64)phase * (juce::uint64)resolution);
+			return static_cast<float>(belowIndex) * (1.f / 4294967296.f);
+		}
+	};
+
+	// Control rate modulation: a destination computes its modulated value, including expensive mappings like
+	// exp2f or tan, only once every controlBlockSize samples and ramps linearly in between. That follows
+	// envelopes closely without a transcendental call per sample.
+	class ControlRamp {
+	public:
+		ControlRamp(int t_controlBlockSize = configuration::CONTROL_BLOCK_SIZE);
+
+		// the next ramp starts right at its first value instead of gliding there from the last one
+		void reset();
+
+		// writes numSamples values to ramp. valueAt(i) is asked for the value at the last sample i of every
+		// control block, the ramp reaches it there coming from the value of the control point before
+		template <typename ValueAt>
+		void process(float* ramp, int numSamples, ValueAt&& valueAt) {
+			for (int start = 0; start < numSamples; start += controlBlockSize) {
+				auto length = juce::jmin(controlBlockSize, numSamples - start);
+				auto target = static_cast<float>(valueAt(start + length - 1));
+				if (isFirst) {
+					current = target;
+					isFirst = false;
+				}
+				auto increment = (target - current) / (float)length;
+				fill(ramp + start, length, current + increment, increment);
+				current = target;
+			}
+		}
+
+		int getControlBlockSize() const {
+			return controlBlockSize;
+		}
+
+		// dest[i] = start + i * increment, a SIMD register at a time
+		static void fill(float* dest, int numSamples, float start, float increment);
+		// dest[i] += start + i * increment, a SIMD register at a time
+		static void add(float* dest, int numSamples, float start, float increment);
+
+	private:
+		template <bool addToDest>
+		static void write(float* dest, int numSamples, float start, float increment);
+
+		int controlBlockSize;
+		float current = 0.f;
+		bool isFirst = true;
+	};
+
+	// Fades from an old signal to a new one over a fixed time, which may span several blocks.
+	// All memory is allocated in prepare, so it can be used when switching processors on the audio thread.
+	class Crossfade {
+	public:
+		void prepare(const juce::dsp::ProcessSpec& spec, double fadeTimeSec = 0.01);
+
+		void start();
+
+		bool isActive() const;
+
+		// copies the current content of block into an internal buffer and returns it,
+		// so the old processor can render into it while the new one works on block itself
+		juce::dsp::AudioBlock<float> copyForOldSignal(const juce::dsp::AudioBlock<float>& block);
+
+		// mixes the old signal into newSignal with a decreasing gain and advances the fade
+		void apply(juce::dsp::AudioBlock<float>& newSignal);
+
+	private:
+		juce::AudioBuffer<float> buffer;
+		int fadeSamples = 0;
+		int remainingSamples = 0;
+	};
+
 	class DummyProcessor : public Processor {
 	public:
 
@@ -87,12 +197,12 @@ namespace customDsp {
 				juce::ignoreUnused(layout);
 			}
 
-			virtual void registerAsListener(juce::AudioProcessorValueTreeState& apvts) override {
-				juce::ignoreUnused(apvts);
+			virtual void registerAsListener(ParameterSnapshot& parameters) override {
+				juce::ignoreUnused(parameters);
 			}
 
-			virtual void parameterChanged(const juce::String& parameterID, float newValue) override {
-				juce::ignoreUnused(parameterID, newValue);
+			virtual void parameterChanged(configuration::ParamSuffix suffix, float newValue) override {
+				juce::ignoreUnused(suffix, newValue);
 			}
 
 		private:
@@ -160,12 +270,166 @@ namespace customDsp {
 
 		virtual bool process(juce::dsp::ProcessContextNonReplacing<float>& context, juce::dsp::AudioBlock<float>& workBuffers) override;
 
+		// bit i decides whether processor i (and so output channel i) gets processed at all.
+		// skipped processors still get noteOn/noteOff, but their channel is left untouched
+		void setActiveProcessors(juce::uint32 mask);
+
+		bool isProcessorActive(int index) const;
+
 	private:
+		juce::uint32 activeProcessors = ~0u;
 
 		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SplitProcessor)
 	};
 
-	class InterpolationOsc : public Processor {
+	// A chain whose processor types are fixed at compile time. The processors are called directly instead of
+	// through the virtual functions of Processor, so the compiler can inline the whole chain.
+	template<typename... Processors>
+	class StaticChain {
+	public:
+		static constexpr int NUM_PROCESSORS = (int)sizeof...(Processors);
+
+		template<int index>
+		using ProcessorType = std::tuple_element_t<(size_t)index, std::tuple<Processors...>>;
+
+		StaticChain() {}
+
+		// dataArray has to hold the SharedData of the chain's processor types, in the same order
+		void createProcessors(const juce::OwnedArray<Processor::SharedData>& dataArray) {
+			jassert(dataArray.size() == NUM_PROCESSORS);
+			createFrom(dataArray, std::index_sequence_for<Processors...>{});
+		}
+
+		template<int index>
+		ProcessorType<index>& get() {
+			return *std::get<(size_t)index>(processors);
+		}
+
+		void prepare(const juce::dsp::ProcessSpec& spec) {
+			forEach([&](auto& p) { p.prepare(spec); });
+		}
+
+		void reset() {
+			forEach([](auto& p) { p.reset(); });
+		}
+
+		bool process(juce::dsp::ProcessContextNonReplacing<float>& context, juce::dsp::AudioBlock<float>& workBuffers) {
+			return processFrom<0>(context, workBuffers);
+		}
+
+		// only processes the processors starting at firstIndex
+		template<int firstIndex>
+		bool processFrom(juce::dsp::ProcessContextNonReplacing<float>& context, juce::dsp::AudioBlock<float>& workBuffers) {
+			static_assert(firstIndex >= 0 && firstIndex <= NUM_PROCESSORS);
+			return processRange<(size_t)firstIndex>(context, workBuffers, std::make_index_sequence<(size_t)(NUM_PROCESSORS - firstIndex)>{});
+		}
+
+		void noteOn() {
+			forEach([](auto& p) { p.noteOn(); });
+		}
+
+		void noteOff() {
+			forEach([](auto& p) { p.noteOff(); });
+		}
+
+	private:
+		template<typename Function>
+		void forEach(Function&& function) {
+			std::apply([&](auto&... p) { (function(*p), ...); }, processors);
+		}
+
+		template<size_t... indices>
+		void createFrom(const juce::OwnedArray<Processor::SharedData>& dataArray, std::index_sequence<indices...>) {
+			([&] {
+				using Data = typename ProcessorType<(int)indices>::SharedData;
+				// the order of dataArray has to match the chain, a mismatch would be undefined behaviour
+				jassert(dynamic_cast<Data*>(dataArray[(int)indices]) != nullptr);
+				// createProcessor of the concrete SharedData already returns the concrete processor
+				std::get<indices>(processors).reset(static_cast<Data*>(dataArray[(int)indices])->createProcessor());
+			}(), ...);
+		}
+
+		template<size_t firstIndex, size_t... indices>
+		bool processRange(juce::dsp::ProcessContextNonReplacing<float>& context, juce::dsp::AudioBlock<float>& workBuffers,
+			std::index_sequence<indices...>) {
+			bool needMoreTime = false;
+			((needMoreTime |= std::get<firstIndex + indices>(processors)->process(context, workBuffers)), ...);
+			return needMoreTime;
+		}
+
+		std::tuple<std::unique_ptr<Processors>...> processors;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StaticChain)
+	};
+
+	// RepeatedChain<T, n>::Type is a StaticChain of n processors of type T
+	template<typename T, int count, typename = std::make_index_sequence<(size_t)count>>
+	struct RepeatedChain;
+
+	template<typename T, int count, size_t... indices>
+	struct RepeatedChain<T, count, std::index_sequence<indices...>> {
+		template<size_t>
+		struct Repeat { using Type = T; };
+
+		using Type = StaticChain<typename Repeat<indices>::Type...>;
+	};
+
+	// how InterpolationOsc interpolates between the samples of a table
+	enum class InterpolationQuality {
+		LINEAR,
+		HERMITE,
+		LAGRANGE,
+	};
+
+	inline static const juce::StringArray INTERPOLATION_QUALITY_NAMES{
+		"Linear",
+		"Hermite",
+		"Lagrange",
+	};
+
+	// Kernels for the interpolation between samples y0 and y1 at 0 <= t < 1, with the neighbours ym1 and y2.
+	// T is float or a juce::dsp::SIMDRegister<float>, so the batched oscillators use the same kernels.
+	// NUM_POINTS tells the caller which neighbours actually need to be read
+	struct LinearKernel {
+		static constexpr int NUM_POINTS = 2;
+
+		template <typename T>
+		static T interpolate(T ym1, T y0, T y1, T y2, T t) {
+			juce::ignoreUnused(ym1, y2);
+			return y0 + t * (y1 - y0);
+		}
+	};
+
+	// catmull-rom spline, continuous in the first derivative
+	struct HermiteKernel {
+		static constexpr int NUM_POINTS = 4;
+
+		template <typename T>
+		static T interpolate(T ym1, T y0, T y1, T y2, T t) {
+			auto c1 = (y1 - ym1) * 0.5f;
+			auto c2 = ym1 - y0 * 2.5f + y1 * 2.f - y2 * 0.5f;
+			auto c3 = (y2 - ym1) * 0.5f + (y0 - y1) * 1.5f;
+			return ((c3 * t + c2) * t + c1) * t + y0;
+		}
+	};
+
+	// third order polynomial through all four points
+	struct LagrangeKernel {
+		static constexpr int NUM_POINTS = 4;
+
+		template <typename T>
+		static T interpolate(T ym1, T y0, T y1, T y2, T t) {
+			auto tp1 = t + 1.f;
+			auto tm1 = t - 1.f;
+			auto tm2 = t - 2.f;
+			return ym1 * (t * tm1 * tm2 * (-1.f / 6.f))
+				+ y0 * (tp1 * tm1 * tm2 * 0.5f)
+				+ y1 * (tp1 * t * tm2 * -0.5f)
+				+ y2 * (tp1 * t * tm1 * (1.f / 6.f));
+		}
+	};
+
+	class InterpolationOsc final : public Processor {
 	public:
 
 		struct SharedData : public Processor::SharedData {
@@ -173,7 +437,9 @@ namespace customDsp {
 
 			bool bypassed{ false };
 			float wtPos{ 0.f }, pitch{ 0.f };
+			InterpolationQuality quality{ InterpolationQuality::LINEAR };
 			wavetable::Wavetable::Ptr wt;
+			wavetable::WavetableHandoff wtHandoff;
 			ModulationParam modParams[3];
 			enum {
 				ENV,
@@ -185,9 +451,9 @@ namespace customDsp {
 
 			virtual void addParams(juce::AudioProcessorValueTreeState::ParameterLayout& layout) override;
 
-			virtual void registerAsListener(juce::AudioProcessorValueTreeState& apvts) override;
+			virtual void registerAsListener(ParameterSnapshot& parameters) override;
 
-			virtual void parameterChanged(const juce::String& parameterID, float newValue) override;
+			virtual void parameterChanged(configuration::ParamSuffix suffix, float newValue) override;
 		private:
 
 			JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SharedData)
@@ -204,6 +470,25 @@ namespace customDsp {
 
 		virtual bool process(juce::dsp::ProcessContextNonReplacing<float>& context, juce::dsp::AudioBlock<float>& workBuffers) override;
 
+		// number of oscillators processBatch renders at once, one per SIMD lane
+		static constexpr int BATCH_SIZE = (int)juce::dsp::SIMDRegister<float>::SIMDNumElements;
+
+		// everything process would get from its context, for a single oscillator of a batch
+		struct BatchItem {
+			InterpolationOsc* osc = nullptr;
+			juce::dsp::AudioBlock<const float> inputBlock;
+			juce::dsp::AudioBlock<float> outputBlock;
+			juce::dsp::AudioBlock<float> workBuffers;
+			// set by processBatch, same meaning as the return value of process
+			bool needMoreTime = false;
+		};
+
+		// same as calling process for every item, but renders the waveforms of up to BATCH_SIZE oscillators
+		// (usually the same oscillator of different voices) side by side in the lanes of a SIMD register.
+		// all blocks need to have the same number of samples. an oscillator without a partner of the same quality
+		// just goes through process
+		static void processBatch(BatchItem* items, int numItems);
+
 		void setFrequency(float t_frequency, bool force = true);
 
 		void setVelocity(float t_velocity);
@@ -213,11 +498,28 @@ namespace customDsp {
 		virtual void noteOff();
 
 	private:
+		// the kernel is fixed for the whole block, so the sample loops don't branch on the quality
+		template <typename Kernel>
+		bool processWith(juce::dsp::ProcessContextNonReplacing<float>& context, juce::dsp::AudioBlock<float>& workBuffers);
+		template <typename Kernel>
+		static void processLanes(BatchItem** lanes, int numLanes);
+		// the sample at index (which may be -1 or up to resolution + 1) of a channel with resolution + 1 samples
+		static int wrapIndex(int index, int resolution) {
+			// selects instead of branches
+			index += index < 0 ? resolution : 0;
+			return index - (index > resolution ? resolution : 0);
+		}
+
+		bool isProducingOutput();
+		// applies the envelope and the release fade and adds the rendered wave from workBuffers to all output channels
+		bool finishBlock(const juce::dsp::AudioBlock<const float>& inputBlock,
+			juce::dsp::AudioBlock<float>& outputBlock, juce::dsp::AudioBlock<float>& workBuffers);
+
 		SharedData* data;
 
 		float frequency = 440.f;
 		float velocity = 0.f;
-		juce::dsp::Phase<float> phase;
+		PhaseAccumulator phase;
 		bool shouldStopCleanly = false;
 		static constexpr int MAX_RELEASE_SAMPLES = 500;
 		int currentReleaseSamples = 0;
@@ -226,7 +528,7 @@ namespace customDsp {
 	};
 
 
-	class Gain : public Processor {
+	class Gain final : public Processor {
 	public:
 
 		struct SharedData : public Processor::SharedData {
@@ -242,9 +544,9 @@ namespace customDsp {
 
 			virtual void addParams(juce::AudioProcessorValueTreeState::ParameterLayout& layout) override;
 
-			virtual void registerAsListener(juce::AudioProcessorValueTreeState& apvts) override;
+			virtual void registerAsListener(ParameterSnapshot& parameters) override;
 
-			virtual void parameterChanged(const juce::String& parameterID, float newValue) override;
+			virtual void parameterChanged(configuration::ParamSuffix suffix, float newValue) override;
 
 		private:
 
@@ -265,13 +567,13 @@ namespace customDsp {
 
 	private:
 		SharedData* data;
-		juce::SmoothedValue<float> gainSmoothed;
+		ControlRamp gainRamp;
 
 		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Gain);
 	};
 
 
-	class Pan : public Processor {
+	class Pan final : public Processor {
 	public:
 
 		struct SharedData : public Processor::SharedData {
@@ -287,9 +589,9 @@ namespace customDsp {
 
 			virtual void addParams(juce::AudioProcessorValueTreeState::ParameterLayout& layout) override;
 
-			virtual void registerAsListener(juce::AudioProcessorValueTreeState& apvts) override;
+			virtual void registerAsListener(ParameterSnapshot& parameters) override;
 
-			virtual void parameterChanged(const juce::String& parameterID, float newValue) override;
+			virtual void parameterChanged(configuration::ParamSuffix suffix, float newValue) override;
 
 		private:
 
@@ -303,12 +605,13 @@ namespace customDsp {
 
 		virtual void prepare(const juce::dsp::ProcessSpec& spec) override;
 
-		virtual void reset() override {}
+		virtual void reset() override;
 
 		virtual bool process(juce::dsp::ProcessContextNonReplacing<float>& context, juce::dsp::AudioBlock<float>& workBuffers) override;
 
 	private:
 		SharedData* data;
+		ControlRamp panRamp;
 
 		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Pan);
 	};
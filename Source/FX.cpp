@@ -75,70 +75,78 @@ namespace customDsp {
 		modParams[PARAMETER_2].addModParams(layout, prefix + configuration::PARAMETER_2_SUFFIX);
 	}
 
-	void FXChooser::SharedData::registerAsListener(juce::AudioProcessorValueTreeState& apvts) {
-		apvts.addParameterListener(prefix + configuration::BYPASSED_SUFFIX, this);
-		apvts.addParameterListener(prefix + configuration::FX_TYPE_SUFFIX, this);
-		apvts.addParameterListener(prefix + configuration::DRY_WET_SUFFIX, this);
-		modParams[DRY_WET].registerAsListener(apvts, prefix + configuration::DRY_WET_SUFFIX);
-		apvts.addParameterListener(prefix + configuration::PARAMETER_0_SUFFIX, this);
-		modParams[PARAMETER_0].registerAsListener(apvts, prefix + configuration::PARAMETER_0_SUFFIX);
-		apvts.addParameterListener(prefix + configuration::PARAMETER_1_SUFFIX, this);
-		modParams[PARAMETER_1].registerAsListener(apvts, prefix + configuration::PARAMETER_1_SUFFIX);
-		apvts.addParameterListener(prefix + configuration::PARAMETER_2_SUFFIX, this);
-		modParams[PARAMETER_2].registerAsListener(apvts, prefix + configuration::PARAMETER_2_SUFFIX);
-	}
-
-	void FXChooser::SharedData::parameterChanged(const juce::String& parameterID, float newValue) {
-		if (parameterID.endsWith(prefix + configuration::BYPASSED_SUFFIX)) {
-			bypassed = static_cast<bool>(newValue);
-		}
-		else if (parameterID.endsWith(prefix + configuration::FX_TYPE_SUFFIX)) {
-			fxType = static_cast<FXType>(newValue);
-		}
-		else if (parameterID.endsWith(prefix + configuration::DRY_WET_SUFFIX)) {
-			dryWet = newValue;
-		}
-		else if (parameterID.endsWith(prefix + configuration::PARAMETER_0_SUFFIX)) {
-			parameter0 = newValue;
-		}
-		else if (parameterID.endsWith(prefix + configuration::PARAMETER_1_SUFFIX)) {
-			parameter1 = newValue;
-		}
-		else if (parameterID.endsWith(prefix + configuration::PARAMETER_2_SUFFIX)) {
-			parameter2 = newValue;
+	void FXChooser::SharedData::registerAsListener(ParameterSnapshot& parameters) {
+		parameters.addParameterListener(prefix + configuration::BYPASSED_SUFFIX, configuration::ParamSuffix::BYPASSED, this);
+		parameters.addParameterListener(prefix + configuration::FX_TYPE_SUFFIX, configuration::ParamSuffix::FX_TYPE, this);
+		parameters.addParameterListener(prefix + configuration::DRY_WET_SUFFIX, configuration::ParamSuffix::DRY_WET, this);
+		modParams[DRY_WET].registerAsListener(parameters, prefix + configuration::DRY_WET_SUFFIX);
+		parameters.addParameterListener(prefix + configuration::PARAMETER_0_SUFFIX, configuration::ParamSuffix::PARAMETER_0, this);
+		modParams[PARAMETER_0].registerAsListener(parameters, prefix + configuration::PARAMETER_0_SUFFIX);
+		parameters.addParameterListener(prefix + configuration::PARAMETER_1_SUFFIX, configuration::ParamSuffix::PARAMETER_1, this);
+		modParams[PARAMETER_1].registerAsListener(parameters, prefix + configuration::PARAMETER_1_SUFFIX);
+		parameters.addParameterListener(prefix + configuration::PARAMETER_2_SUFFIX, configuration::ParamSuffix::PARAMETER_2, this);
+		modParams[PARAMETER_2].registerAsListener(parameters, prefix + configuration::PARAMETER_2_SUFFIX);
+	}
+
+	void FXChooser::SharedData::parameterChanged(configuration::ParamSuffix suffix, float newValue) {
+		switch (suffix) {
+		case configuration::ParamSuffix::BYPASSED: bypassed = static_cast<bool>(newValue); break;
+		case configuration::ParamSuffix::FX_TYPE: fxType = static_cast<FXType>(newValue); break;
+		case configuration::ParamSuffix::DRY_WET: dryWet = newValue; break;
+		case configuration::ParamSuffix::PARAMETER_0: parameter0 = newValue; break;
+		case configuration::ParamSuffix::PARAMETER_1: parameter1 = newValue; break;
+		case configuration::ParamSuffix::PARAMETER_2: parameter2 = newValue; break;
+		default: jassertfalse; break;
 		}
 	}
 
-	void FXChooser::createFX(FXType type)
+	FXChooser::FXChooser(SharedData* t_data) : data(t_data)
 	{
-		switch (type) {
-		case FXType::CHORUS: fx = std::make_unique<Chorus>(data); break;
-		case FXType::DELAY: fx = std::make_unique<Delay>(data); break;
-		case FXType::FLANGER: fx = std::make_unique<Flanger>(data); break;
-		case FXType::REVERB: fx = std::make_unique<Reverb>(data); break;
-		case FXType::PHASER: fx = std::make_unique<Phaser>(data); break;
-		case FXType::DISTORTION: fx = std::make_unique<Distortion>(data); break;
-		case FXType::NONE: fx = std::make_unique<DummyFX>(data); break;
-		default: jassertfalse; break;
+		for (int i = 0; i < (int)FXType::NUMBER_OF_TYPES; i++) {
+			auto type = static_cast<FXType>(i);
+			switch (type) {
+			case FXType::CHORUS: fxPool[i] = std::make_unique<Chorus>(data, type); break;
+			case FXType::DELAY: fxPool[i] = std::make_unique<Delay>(data, type); break;
+			case FXType::FLANGER: fxPool[i] = std::make_unique<Flanger>(data, type); break;
+			case FXType::REVERB: fxPool[i] = std::make_unique<Reverb>(data, type); break;
+			case FXType::PHASER: fxPool[i] = std::make_unique<Phaser>(data, type); break;
+			case FXType::DISTORTION: fxPool[i] = std::make_unique<Distortion>(data, type); break;
+			case FXType::NONE: fxPool[i] = std::make_unique<DummyFX>(data, type); break;
+			default: jassertfalse; break;
+			}
 		}
+		fx = fxPool[(int)FXType::NONE].get();
+	}
 
-		fx->prepareUpdate();
-		if (isNoteOn) {
-			fx->noteOn();
-		}
+	FXChooser::~FXChooser() {}
+
+	void FXChooser::activateFX(FXType type)
+	{
+		// the new fx is clean already, every fx gets reset once it's faded out
+		fadingOutFx = fx;
+		fx = fxPool[(int)type].get();
+		crossfade.start();
 	}
 
 	void FXChooser::prepare(const juce::dsp::ProcessSpec& spec)
 	{
 		data->sampleRate = spec.sampleRate;
 		data->numChannels = spec.numChannels;
-		createFX(data->fxType);
+		// all allocations happen here, so switching types later on doesn't need any
+		for (auto& f : fxPool) {
+			f->prepareUpdate();
+		}
+		crossfade.prepare(spec);
+		fx = fxPool[(int)data->fxType].get();
+		fadingOutFx = nullptr;
 	}
 
 	void FXChooser::reset()
 	{
-		if (fx != nullptr) {
-			fx->reset();
+		fx->reset();
+		if (fadingOutFx != nullptr) {
+			fadingOutFx->reset();
+			fadingOutFx = nullptr;
 		}
 	}
 
@@ -147,26 +155,58 @@ namespace customDsp {
 		if (data->bypassed || context.isBypassed) {
 			return false;
 		}
-		if (data->fxType != fx->mode) {
-			createFX(data->fxType);
+		// a switch during a fade waits until it's over, so the fading out fx is never cut off
+		if (data->fxType != fx->mode && fadingOutFx == nullptr) {
+			activateFX(data->fxType);
 		}
-		return fx->process(context, workBuffers);
+		if (fadingOutFx == nullptr) {
+			return fx->process(context, workBuffers);
+		}
+
+		// let the old fx process a copy of the input and fade over to the new one
+		auto oldSignal = crossfade.copyForOldSignal(context.getOutputBlock());
+		juce::dsp::ProcessContextNonReplacing<float> oldContext{ context.getInputBlock(), oldSignal };
+		fadingOutFx->process(oldContext, workBuffers);
+
+		auto needMoreTime = fx->process(context, workBuffers);
+		crossfade.apply(context.getOutputBlock());
+		if (!crossfade.isActive()) {
+			// clear its tail now, so activating it again later doesn't have to
+			fadingOutFx->reset();
+			fadingOutFx = nullptr;
+			return needMoreTime;
+		}
+		return true;
 	}
 
 	void FXChooser::noteOn() {
 		Processor::noteOn();
-		if (fx) {
-			fx->noteOn();
+		for (auto& f : fxPool) {
+			f->noteOn();
 		}
 	}
 
 	void FXChooser::noteOff() {
 		Processor::noteOff();
-		if (fx) {
-			fx->noteOff();
+		for (auto& f : fxPool) {
+			f->noteOff();
 		}
 	}
 
+	float* FX::rampDryWet(const juce::dsp::AudioBlock<const float>& inputBlock, juce::dsp::AudioBlock<float>& workBuffers)
+	{
+		jassert(workBuffers.getNumChannels() > DRY_WET_BUFFER);
+		auto dryWetBase = data->dryWet;
+		auto dryWetMod = data->modParams[FXChooser::SharedData::DRY_WET].factor;
+		auto dryWetModSrc = inputBlock.getChannelPointer((size_t)data->modParams[FXChooser::SharedData::DRY_WET].src_channel);
+
+		auto* dryWetPtr = workBuffers.getChannelPointer(DRY_WET_BUFFER);
+		dryWetRamp.process(dryWetPtr, (int)workBuffers.getNumSamples(), [&](int i) {
+			return juce::jlimit(0.f, 1.f, dryWetBase + dryWetMod * dryWetModSrc[i]);
+			});
+		return dryWetPtr;
+	}
+
 	void Reverb::prepareUpdate()
 	{
 		// SampleRate
@@ -212,6 +252,7 @@ namespace customDsp {
 
 		allPassBuffer[LEFT].clear(leftAllPassBufferSize);
 		allPassBuffer[RIGHT].clear(rightAllPassBufferSize);
+		dryWetRamp.reset();
 	}
 
 	bool Reverb::process(juce::dsp::ProcessContextNonReplacing<float>& context, juce::dsp::AudioBlock<float>& workBuffers)
@@ -227,9 +268,7 @@ namespace customDsp {
 		jassert(workBuffers.getNumChannels() >= 2);
 
 		// prepare for modulation
-		auto dryWetBase = data->dryWet;
-		auto dryWetMod = data->modParams[FXChooser::SharedData::DRY_WET].factor;
-		auto dryWetModSrc = inputBlock.getChannelPointer((size_t)data->modParams[FXChooser::SharedData::DRY_WET].src_channel);
+		auto* dryWetPtr = rampDryWet(inputBlock, workBuffers);
 
 		// parameter2 = width
 		auto widthBase = data->parameter2;
@@ -263,24 +302,27 @@ namespace customDsp {
 		const float gain = 0.025f;// 0.015f;
 		mixedInput.multiplyBy(gain);
 
-		for (int blockStart = 0; blockStart < numSamples; blockStart += configuration::MOD_BLOCK_SIZE) {
-			auto end = juce::jmin(blockStart + configuration::MOD_BLOCK_SIZE, (int)numSamples);
+		for (int blockStart = 0; blockStart < numSamples; blockStart += configuration::CONTROL_BLOCK_SIZE) {
+			auto end = juce::jmin(blockStart + configuration::CONTROL_BLOCK_SIZE, (int)numSamples);
 			auto length = end - blockStart;
 
 			// modulation update
 			auto currentWidth = juce::jlimit(0.f, 1.f, widthBase + widthMod * widthModSrc[blockStart]);
 			auto currentFeedback = juce::jlimit(0.f, 1.f, roomSizeBase + roomSizeMod * roomSizeModSrc[blockStart]) * roomScaleFactor + roomOffset;
 			auto currentDamping = juce::jlimit(0.f, 1.f, dampingBase + dampingMod * dampingModSrc[blockStart]) * dampScaleFactor;
-			auto currentDryWet = juce::jlimit(0.f, 1.f, dryWetBase + dryWetMod * dryWetModSrc[blockStart]);
 
 			const float wetScaleFactor = 2.f;// 3.0f;
 
-			const float wet = currentDryWet * wetScaleFactor;
-			const float dryGain = (1.f - currentDryWet);
-			const float wetGain1 = 0.5f * wet * (1.f + currentWidth);
-			const float wetGain2 = 0.5f * wet * (1.f - currentWidth);
+			// multiplied with the dry/wet ramp per sample
+			const float wetGain1 = 0.5f * wetScaleFactor * (1.f + currentWidth);
+			const float wetGain2 = 0.5f * wetScaleFactor * (1.f - currentWidth);
 
-			outputBlock.getSubBlock(blockStart, length).multiplyBy(dryGain);
+			for (int channel = LEFT; channel <= RIGHT; channel++) {
+				auto* outputChannel = outputBlock.getChannelPointer(channel);
+				for (int i = blockStart; i < end; i++) {
+					outputChannel[i] *= 1.f - dryWetPtr[i];
+				}
+			}
 			// Do calculations first for the left and then for the right side to increase data locality
 			// and decrease the needed work buffers
 			for (int n = LEFT; n <= RIGHT; n++) {
@@ -332,9 +374,13 @@ namespace customDsp {
 					allPassData[n][a].index = bufferIndex;
 				}
 				// mix down
-
-				outputBlock.getSingleChannelBlock(n).getSubBlock(blockStart, length).addProductOf(currentOutWB, wetGain1);
-				outputBlock.getSingleChannelBlock((n + 1) % 2).getSubBlock(blockStart, length).addProductOf(currentOutWB, wetGain2);
+				auto* sameChannel = outputBlock.getChannelPointer(n);
+				auto* otherChannel = outputBlock.getChannelPointer((n + 1) % 2);
+				for (int i = blockStart; i < end; i++) {
+					auto wet = outWBPtr[i] * dryWetPtr[i];
+					sameChannel[i] += wet * wetGain1;
+					otherChannel[i] += wet * wetGain2;
+				}
 			}
 		}
 
@@ -354,11 +400,12 @@ namespace customDsp {
 		for (auto& d : delays) {
 			d.reset();
 		}
+		dryWetRamp.reset();
+		dampRamp.reset();
 	}
 
 	bool Delay::process(juce::dsp::ProcessContextNonReplacing<float>& context, juce::dsp::AudioBlock<float>& workBuffers)
 	{
-		juce::ignoreUnused(workBuffers);
 		if (data->bypassed || context.isBypassed) {
 			return false;
 		}
@@ -367,18 +414,20 @@ namespace customDsp {
 		auto& outputBlock = context.getOutputBlock();
 		const auto numSamples = outputBlock.getNumSamples();
 
-		//jassert(workBuffers.getNumChannels() >= 1);
+		jassert(workBuffers.getNumChannels() >= 1);
 		jassert(data->numChannels == 2);
 		jassert(outputBlock.getNumChannels() == 2);
 
 		// prepare modulation
-		auto dryWetBase = data->dryWet;
-		auto dryWetMod = data->modParams[FXChooser::SharedData::DRY_WET].factor;
-		auto dryWetModSrc = inputBlock.getChannelPointer((size_t)data->modParams[FXChooser::SharedData::DRY_WET].src_channel);
-		// parameter0 = damp
+		auto* dryWetPtr = rampDryWet(inputBlock, workBuffers);
+		// parameter0 = damp, ramped as the gain of the delayed signal
 		auto dampBase = data->parameter0;
 		auto dampMod = data->modParams[FXChooser::SharedData::PARAMETER_0].factor;
 		auto dampModSrc = inputBlock.getChannelPointer((size_t)data->modParams[FXChooser::SharedData::PARAMETER_0].src_channel);
+		auto* delayGainPtr = workBuffers.getChannelPointer(0);
+		dampRamp.process(delayGainPtr, (int)numSamples, [&](int i) {
+			return 1.f - juce::jlimit(0.f, 1.f, dampBase + dampMod * dampModSrc[i]);
+			});
 		// parameter1 = timeLeft
 		auto timeLeftBase = data->parameter1;
 		auto timeLeftMod = data->modParams[FXChooser::SharedData::PARAMETER_1].factor;
@@ -396,13 +445,10 @@ namespace customDsp {
 			juce::jmap(juce::jlimit(0.f, 1.f, timeRightBase + timeRightMod * timeRightModSrc[0]),
 				2.f, MAX_DELAY_SEC * static_cast<float>(data->sampleRate)));
 
-		for (int blockStart = 0; blockStart < numSamples; blockStart += configuration::MOD_BLOCK_SIZE) {
-			auto end = juce::jmin(blockStart + configuration::MOD_BLOCK_SIZE, (int)numSamples);
+		for (int blockStart = 0; blockStart < numSamples; blockStart += configuration::CONTROL_BLOCK_SIZE) {
+			auto end = juce::jmin(blockStart + configuration::CONTROL_BLOCK_SIZE, (int)numSamples);
 			auto length = end - blockStart;
 
-			auto dryWet = juce::jlimit(0.f, 1.f, dryWetBase + dryWetMod * dryWetModSrc[blockStart]);
-			auto damp = juce::jlimit(0.f, 1.f, dampBase + dampMod * dampModSrc[blockStart]);
-
 			delayInSamples[LEFT].setTargetValue(
 				juce::jmap(juce::jlimit(0.f, 1.f, timeLeftBase + timeLeftMod * timeLeftModSrc[end-1]),
 					2.f, MAX_DELAY_SEC * static_cast<float>(data->sampleRate)));
@@ -417,7 +463,7 @@ namespace customDsp {
 				auto& delay = delays[channel];
 				auto outputChannel = outputBlock.getChannelPointer(channel);
 				for (int i = blockStart; i < end; i++) {
-					outputChannel[i] += dryWet * ((1.f - damp) * delay.process(outputChannel[i], delayInSamples[channel].getNextValue(), 0.f)
+					outputChannel[i] += dryWetPtr[i] * (delayGainPtr[i] * delay.process(outputChannel[i], delayInSamples[channel].getNextValue(), 0.f)
 						- outputChannel[i]);
 				}
 			}
@@ -437,7 +483,7 @@ namespace customDsp {
 			d.setMaxDelay(static_cast<int>(1 + MAX_DELAY_MSEC * data->sampleRate / 1000.f));
 		}
 		lfoData.sampleRate = data->sampleRate;
-		lfoData.wt = wavetable::WavetableCache::getInstance()->getWavetable(0);
+		lfoData.wt = wavetable::WavetableCache::getInstance()->getWavetable(0, data->sampleRate, wavetable::MipLevels::LOWEST_ONLY);
 		reset();
 	}
 
@@ -449,14 +495,14 @@ namespace customDsp {
 		for (auto& l : lfos) {
 			l.reset();
 		}
-		lfos[RIGHT].advancePhase(juce::MathConstants<float>::halfPi);
+		lfos[RIGHT].advancePhase(0.25);
 		for (auto& s : delaySmoothed) {
 			s.setCurrentAndTargetValue(1);
 		}
 		for (auto& s : feedbackSmoothed) {
 			s.setCurrentAndTargetValue(0);
 		}
-
+		dryWetRamp.reset();
 	}
 
 	bool Flanger::process(juce::dsp::ProcessContextNonReplacing<float>& context, juce::dsp::AudioBlock<float>& workBuffers)
@@ -474,9 +520,7 @@ namespace customDsp {
 		jassert(outputBlock.getNumChannels() == 2);
 
 		// prepare modulation
-		auto dryWetBase = data->dryWet;
-		auto dryWetMod = data->modParams[FXChooser::SharedData::DRY_WET].factor;
-		auto dryWetModSrc = inputBlock.getChannelPointer((size_t)data->modParams[FXChooser::SharedData::DRY_WET].src_channel);
+		auto* dryWetPtr = rampDryWet(inputBlock, workBuffers);
 
 		// parameter0 = rate
 		auto rateBase = data->parameter0;
@@ -493,11 +537,10 @@ namespace customDsp {
 
 		auto emptyBlock = juce::dsp::AudioBlock<float>();
 
-		for (int blockStart = 0; blockStart < numSamples; blockStart += configuration::MOD_BLOCK_SIZE) {
-			auto end = juce::jmin(blockStart + configuration::MOD_BLOCK_SIZE, (int)numSamples);
+		for (int blockStart = 0; blockStart < numSamples; blockStart += configuration::CONTROL_BLOCK_SIZE) {
+			auto end = juce::jmin(blockStart + configuration::CONTROL_BLOCK_SIZE, (int)numSamples);
 			auto length = end - blockStart;
 
-			auto dryWet = juce::jlimit(0.f, 1.f, dryWetBase + dryWetMod * dryWetModSrc[blockStart]);
 			auto normalizedRate = juce::jlimit(0.f, 1.f, rateBase + rateMod * rateModSrc[blockStart]);
 			auto depth = juce::jlimit(0.f, 1.f, depthBase + depthMod * depthModSrc[blockStart]);
 			auto normalizedFeedback = juce::jlimit(0.f, 1.f, feedbackBase + feedbackMod * feedbackModSrc[blockStart]);
@@ -525,7 +568,7 @@ namespace customDsp {
 				auto& delay = delays[channel];
 				for (int i = blockStart; i < end; i++) {
 					outputChannel[i] +=
-						dryWet * (delay.process(outputChannel[i], delaySmoothed[channel].getNextValue(), feedbackSmoothed[channel].getNextValue())
+						dryWetPtr[i] * (delay.process(outputChannel[i], delaySmoothed[channel].getNextValue(), feedbackSmoothed[channel].getNextValue())
 							- outputChannel[i]);
 				}
 			}
@@ -540,7 +583,7 @@ namespace customDsp {
 			d.setMaxDelay(static_cast<int>(1 + MAX_DELAY_MSEC * data->sampleRate / 1000.f));
 		}
 		lfoData.sampleRate = data->sampleRate;
-		lfoData.wt = wavetable::WavetableCache::getInstance()->getWavetable(0);
+		lfoData.wt = wavetable::WavetableCache::getInstance()->getWavetable(0, data->sampleRate, wavetable::MipLevels::LOWEST_ONLY);
 		reset();
 	}
 
@@ -552,13 +595,14 @@ namespace customDsp {
 		for (auto& l : lfos) {
 			l.reset();
 		}
-		lfos[RIGHT].advancePhase(juce::MathConstants<float>::halfPi);
+		lfos[RIGHT].advancePhase(0.25);
 		for (auto& s : centreDelaySmoothed) {
 			s.setCurrentAndTargetValue(static_cast<float>(((MAX_DELAY_MSEC + MIN_DELAY_MSEC) / 2.f) * data->sampleRate / 1000.f));
 		}
 		for (auto& s : delaySmoothed) {
 			s.setCurrentAndTargetValue(static_cast<float>(((MAX_DELAY_MSEC + MIN_DELAY_MSEC) / 2.f) * data->sampleRate / 1000.f));
 		}
+		dryWetRamp.reset();
 	}
 
 	bool Chorus::process(juce::dsp::ProcessContextNonReplacing<float>& context, juce::dsp::AudioBlock<float>& workBuffers)
@@ -576,9 +620,7 @@ namespace customDsp {
 		jassert(outputBlock.getNumChannels() == 2);
 
 		// prepare modulation
-		auto dryWetBase = data->dryWet;
-		auto dryWetMod = data->modParams[FXChooser::SharedData::DRY_WET].factor;
-		auto dryWetModSrc = inputBlock.getChannelPointer((size_t)data->modParams[FXChooser::SharedData::DRY_WET].src_channel);
+		auto* dryWetPtr = rampDryWet(inputBlock, workBuffers);
 
 		// parameter0 = rate
 		auto rateBase = data->parameter0;
@@ -599,11 +641,10 @@ namespace customDsp {
 		const auto maxDelaySamples = MAX_DELAY_MSEC * static_cast<float>(data->sampleRate) / 1000.f;
 		const auto delayRange = maxDelaySamples - minDelaySamples;
 
-		for (int blockStart = 0; blockStart < numSamples; blockStart += configuration::MOD_BLOCK_SIZE) {
-			auto end = juce::jmin(blockStart + configuration::MOD_BLOCK_SIZE, (int)numSamples);
+		for (int blockStart = 0; blockStart < numSamples; blockStart += configuration::CONTROL_BLOCK_SIZE) {
+			auto end = juce::jmin(blockStart + configuration::CONTROL_BLOCK_SIZE, (int)numSamples);
 			auto length = end - blockStart;
 
-			auto dryWet = juce::jlimit(0.f, 1.f, dryWetBase + dryWetMod * dryWetModSrc[blockStart]);
 			auto normalizedRate = juce::jlimit(0.f, 1.f, rateBase + rateMod * rateModSrc[blockStart]);
 			auto normalizedDepth = juce::jlimit(0.f, 1.f, depthBase + depthMod * depthModSrc[blockStart]);
 			auto normalizedCentreDelay = juce::jlimit(0.f, 1.f, centreDelayBase + centreDelayMod * centreDelayModSrc[blockStart]);
@@ -632,7 +673,7 @@ namespace customDsp {
 					auto currentDelay = juce::jlimit(minDelaySamples, maxDelaySamples,
 						centreDelaySmoothed[channel].getNextValue() + delaySmoothed[channel].getNextValue());
 					outputChannel[i] +=
-						dryWet * (delay.process(outputChannel[i], currentDelay, 0.f) - outputChannel[i]);
+						dryWetPtr[i] * (delay.process(outputChannel[i], currentDelay, 0.f) - outputChannel[i]);
 				}
 			}
 		}
@@ -643,20 +684,21 @@ namespace customDsp {
 
 	void Phaser::prepareUpdate() {
 		lfoData.sampleRate = data->sampleRate;
-		lfoData.wt = wavetable::WavetableCache::getInstance()->getWavetable(0);
+		lfoData.wt = wavetable::WavetableCache::getInstance()->getWavetable(0, data->sampleRate, wavetable::MipLevels::LOWEST_ONLY);
 		reset();
 	}
 	void Phaser::reset() {
 		for (auto& l : lfos) {
 			l.reset();
 		}
-		lfos[RIGHT].advancePhase(juce::MathConstants<float>::halfPi);
+		lfos[RIGHT].advancePhase(0.25);
 		for (int i = 0; i < STAGES; i++) {
 			allpassS1[LEFT][i] = 0.f;
 			allpassS1[RIGHT][i] = 0.f;
 		}
 		last[LEFT] = 0.f;
 		last[RIGHT] = 0.f;
+		dryWetRamp.reset();
 	}
 
 	bool Phaser::process(juce::dsp::ProcessContextNonReplacing<float>& context, juce::dsp::AudioBlock<float>& workBuffers) {
@@ -674,9 +716,7 @@ namespace customDsp {
 		jassert(outputBlock.getNumChannels() == 2);
 
 		// prepare modulation
-		auto dryWetBase = data->dryWet;
-		auto dryWetMod = data->modParams[FXChooser::SharedData::DRY_WET].factor;
-		auto dryWetModSrc = inputBlock.getChannelPointer((size_t)data->modParams[FXChooser::SharedData::DRY_WET].src_channel);
+		auto* dryWetPtr = rampDryWet(inputBlock, workBuffers);
 
 		// parameter0 = rate
 		auto rateBase = data->parameter0;
@@ -693,11 +733,10 @@ namespace customDsp {
 
 		auto emptyBlock = juce::dsp::AudioBlock<float>();
 
-		for (int blockStart = 0; blockStart < numSamples; blockStart += configuration::MOD_BLOCK_SIZE) {
-			auto end = juce::jmin(blockStart + configuration::MOD_BLOCK_SIZE, (int)numSamples);
+		for (int blockStart = 0; blockStart < numSamples; blockStart += configuration::CONTROL_BLOCK_SIZE) {
+			auto end = juce::jmin(blockStart + configuration::CONTROL_BLOCK_SIZE, (int)numSamples);
 			auto length = end - blockStart;
 
-			auto dryWet = juce::jlimit(0.f, 1.f, dryWetBase + dryWetMod * dryWetModSrc[blockStart]);
 			auto normalizedRate = juce::jlimit(0.f, 1.f, rateBase + rateMod * rateModSrc[blockStart]);
 			auto normalizedDepth = juce::jlimit(0.f, 1.f, depthBase + depthMod * depthModSrc[blockStart]);
 			auto feedback = juce::jlimit(0.f, 0.9f, feedbackBase + feedbackMod * feedbackModSrc[blockStart]);
@@ -734,7 +773,7 @@ namespace customDsp {
 					}
 					last[channel] = input;
 
-					outputChannel[i] += dryWet * (input - outputChannel[i]);
+					outputChannel[i] += dryWetPtr[i] * (input - outputChannel[i]);
 				}
 			}
 		}
@@ -747,10 +786,11 @@ namespace customDsp {
 	void Distortion::reset() {
 		filterS1[0] = 0.f;
 		filterS1[1] = 0.f;
+		dryWetRamp.reset();
+		cutoffRamp.reset();
 	}
 
 	bool Distortion::process(juce::dsp::ProcessContextNonReplacing<float>& context, juce::dsp::AudioBlock<float>& workBuffers) {
-		juce::ignoreUnused(workBuffers);
 		if (data->bypassed || context.isBypassed) {
 			return false;
 		}
@@ -759,19 +799,24 @@ namespace customDsp {
 		auto& outputBlock = context.getOutputBlock();
 		const auto numSamples = outputBlock.getNumSamples();
 
-		//jassert(workBuffers.getNumChannels() >= 1);
+		jassert(workBuffers.getNumChannels() >= 1);
 		jassert(data->numChannels == 2);
 		jassert(outputBlock.getNumChannels() == 2);
 
 		// prepare modulation
-		auto dryWetBase = data->dryWet;
-		auto dryWetMod = data->modParams[FXChooser::SharedData::DRY_WET].factor;
-		auto dryWetModSrc = inputBlock.getChannelPointer((size_t)data->modParams[FXChooser::SharedData::DRY_WET].src_channel);
+		auto* dryWetPtr = rampDryWet(inputBlock, workBuffers);
 
 		// parameter0 = cutoff
 		auto cutoffBase = data->parameter0;
 		auto cutoffMod = data->modParams[FXChooser::SharedData::PARAMETER_0].factor;
 		auto cutoffModSrc = inputBlock.getChannelPointer((size_t)data->modParams[FXChooser::SharedData::PARAMETER_0].src_channel);
+		auto* GPtr = workBuffers.getChannelPointer(0);
+		cutoffRamp.process(GPtr, (int)numSamples, [&](int i) {
+			auto normalizedCutoff = juce::jlimit(0.f, 1.f, cutoffBase + cutoffMod * cutoffModSrc[i]);
+			auto cutoff = 20.f * std::powf(20000.f / 20.f, normalizedCutoff);
+			auto g = juce::dsp::FastMathApproximations::tan<float>(juce::MathConstants<float>::pi * cutoff / static_cast<float>(data->sampleRate));
+			return g / (g + 1);
+			});
 		// parameter1 = filterPos
 		auto filterPosBase = data->parameter1;
 		auto filterPosMod = data->modParams[FXChooser::SharedData::PARAMETER_1].factor;
@@ -792,25 +837,19 @@ namespace customDsp {
 			return false;
 		}
 
-		for (int blockStart = 0; blockStart < numSamples; blockStart += configuration::MOD_BLOCK_SIZE) {
-			auto end = juce::jmin(blockStart + configuration::MOD_BLOCK_SIZE, (int)numSamples);
+		for (int blockStart = 0; blockStart < numSamples; blockStart += configuration::CONTROL_BLOCK_SIZE) {
+			auto end = juce::jmin(blockStart + configuration::CONTROL_BLOCK_SIZE, (int)numSamples);
 
-			auto dryWet = juce::jlimit(0.f, 1.f, dryWetBase + dryWetMod * dryWetModSrc[blockStart]);
-			auto normalizedCutoff = juce::jlimit(0.f, 1.f, cutoffBase + cutoffMod * cutoffModSrc[blockStart]);
 			auto filterPos = juce::jlimit(0.f, 1.f, filterPosBase + filterPosMod * filterPosModSrc[blockStart]);
 			float k = 1.f + juce::jlimit(0.f, 1.f, kBase + kMod * kModSrc[blockStart]) * 4.f;
 			auto feedback = juce::jlimit(0.f, .85f, kBase + kMod * kModSrc[blockStart]);
 
-			auto cutoff = 20.f * std::powf(20000.f / 20.f, normalizedCutoff);
-			auto g = juce::dsp::FastMathApproximations::tan<float>(juce::MathConstants<float>::pi * cutoff / static_cast<float>(data->sampleRate));
-			auto G = g / (g + 1);
-
 			for (int channel = 0; channel < outputBlock.getNumChannels(); channel++) {
 
 				auto outputChannel = outputBlock.getChannelPointer(channel);
 				for (int i = blockStart; i < end; i++) {
 					auto input = outputChannel[i] + feedback * last[channel];
-					auto v = G * (input - filterS1[channel]);
+					auto v = GPtr[i] * (input - filterS1[channel]);
 					auto y = v + filterS1[channel];
 					filterS1[channel] = y + v;
 
@@ -821,7 +860,7 @@ namespace customDsp {
 
 					input = juce::dsp::FastMathApproximations::tanh(k * variableSignal) + fixedSignal;
 					last[channel] = input;
-					outputChannel[i] += dryWet * (input - outputChannel[i]);
+					outputChannel[i] += dryWetPtr[i] * (input - outputChannel[i]);
 
 				}
 			}
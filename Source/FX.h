@@ -65,7 +65,7 @@ namespace customDsp {
 
 	class FX;
 
-	class FXChooser : public Processor {
+	class FXChooser final : public Processor {
 	public:
 
 		struct SharedData : public Processor::SharedData {
@@ -89,9 +89,9 @@ namespace customDsp {
 
 			virtual void addParams(juce::AudioProcessorValueTreeState::ParameterLayout& layout) override;
 
-			virtual void registerAsListener(juce::AudioProcessorValueTreeState& apvts) override;
+			virtual void registerAsListener(ParameterSnapshot& parameters) override;
 
-			virtual void parameterChanged(const juce::String& parameterID, float newValue) override;
+			virtual void parameterChanged(configuration::ParamSuffix suffix, float newValue) override;
 
 		private:
 
@@ -99,10 +99,11 @@ namespace customDsp {
 		};
 
 		FXChooser() = delete;
-		FXChooser(SharedData* t_data) : data(t_data) {}
-		virtual ~FXChooser() override {};
+		FXChooser(SharedData* t_data);
+		virtual ~FXChooser() override;
 
-		void createFX(FXType type);
+		// only swaps pointers, so it's safe to call on the audio thread
+		void activateFX(FXType type);
 
 		virtual void prepare(const juce::dsp::ProcessSpec& spec) override;
 
@@ -115,7 +116,12 @@ namespace customDsp {
 		virtual void noteOff() override;
 	private:
 		SharedData* data;
-		std::unique_ptr<FX> fx;
+		// one instance of every fx type, created and prepared up front
+		std::unique_ptr<FX> fxPool[(int)FXType::NUMBER_OF_TYPES];
+		FX* fx = nullptr;
+		// the previously active fx while it is faded out. all other fx in the pool are reset
+		FX* fadingOutFx = nullptr;
+		Crossfade crossfade;
 
 		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FXChooser)
 	};
@@ -123,7 +129,7 @@ namespace customDsp {
 	class FX : public Processor {
 	public:
 		FX() = delete;
-		FX(FXChooser::SharedData* t_data) : data(t_data) { mode = data->fxType; };
+		FX(FXChooser::SharedData* t_data, FXType t_mode) : mode(t_mode), data(t_data) {};
 		virtual ~FX() override {}
 
 		virtual void prepare(const juce::dsp::ProcessSpec& spec) override {
@@ -135,7 +141,15 @@ namespace customDsp {
 
 		FXType mode{ FXType::NONE };
 	protected:
+		// the last work buffer holds the dry/wet ramp, the ones before are free for the fx itself
+		static constexpr int DRY_WET_BUFFER = WORK_BUFFERS - 1;
+
+		// writes the modulated dry/wet of every sample to the dry/wet work buffer and returns it
+		float* rampDryWet(const juce::dsp::AudioBlock<const float>& inputBlock, juce::dsp::AudioBlock<float>& workBuffers);
+
 		FXChooser::SharedData* data;
+		// every fx of the pool has its own, so the fading out fx of a switch keeps gliding from its last value
+		ControlRamp dryWetRamp;
 
 	private:
 
@@ -246,6 +260,7 @@ namespace customDsp {
 		};
 		juce::SmoothedValue<float> delaySmoothed[2];
 		DelayLine delays[2]{};
+		ControlRamp dampRamp;
 		static constexpr float MAX_DELAY_SEC = 1.f;
 	};
 
@@ -332,5 +347,7 @@ namespace customDsp {
 	private:
 		float filterS1[2]{ 0 };
 		float last[2]{ 0,0 };
+		// ramps the filter coefficient G, like TPTFilter does with g
+		ControlRamp cutoffRamp;
 	};
 }
\ No newline at end of file
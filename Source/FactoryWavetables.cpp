@@ -0,0 +1,21 @@
+#include "FactoryWavetables.h"
+
+namespace wavetable::factory {
+
+	// FactoryWavetableData.inc is written by Tools/FactoryWavetables, which itself is built without it
+#if __has_include("FactoryWavetableData.inc") && !defined(SYNTH_NO_FACTORY_WAVETABLES)
+	#include "FactoryWavetableData.inc"
+#else
+	static const Entry entries[]{ { nullptr, 0.0, nullptr, 0, 0, 0 } };
+#endif
+
+	const Entry* findEntry(const juce::String& name, double sampleRate)
+	{
+		for (auto& entry : entries) {
+			if (entry.name != nullptr && name == entry.name && entry.sampleRate == sampleRate) {
+				return &entry;
+			}
+		}
+		return nullptr;
+	}
+}
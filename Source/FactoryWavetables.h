@@ -0,0 +1,24 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// The default wavetables for the common sample rates, generated at build time by Tools/FactoryWavetables and
+// linked into the plugin, so they don't have to be generated on first use. Without the generated data every
+// lookup fails and the tables get generated at runtime instead.
+namespace wavetable::factory {
+
+	struct Entry {
+		const char* name;
+		double sampleRate;
+		// compressed table with all mip levels, in the layout SharedWavetableStore::toData writes
+		const unsigned char* data;
+		int size;
+		// SharedWavetableStore::LAYOUT_VERSION and WavetableCache::GENERATOR_VERSION at the time the data was written.
+		// 0 for data written before the versions were recorded
+		int layoutVersion;
+		int generatorVersion;
+	};
+
+	// nullptr if there is no factory table for name at sampleRate. the entry may be of another version
+	const Entry* findEntry(const juce::String& name, double sampleRate);
+}
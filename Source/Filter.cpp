@@ -67,72 +67,83 @@ namespace customDsp {
 		modParams[SPECIAL].addModParams(layout, prefix + configuration::SPECIAL_SUFFIX);
 	}
 
-	void FilterChooser::SharedData::registerAsListener(juce::AudioProcessorValueTreeState& apvts) {
-		apvts.addParameterListener(prefix + configuration::BYPASSED_SUFFIX, this);
-		apvts.addParameterListener(prefix + configuration::FILTER_TYPE_SUFFIX, this);
-		apvts.addParameterListener(prefix + configuration::CUTOFF_SUFFIX, this);
-		modParams[CUTOFF].registerAsListener(apvts, prefix + configuration::CUTOFF_SUFFIX);
-		apvts.addParameterListener(prefix + configuration::RESONANCE_SUFFIX, this);
-		modParams[RES].registerAsListener(apvts, prefix + configuration::RESONANCE_SUFFIX);
-		apvts.addParameterListener(prefix + configuration::DRIVE_SUFFIX, this);
-		modParams[SPECIAL].registerAsListener(apvts, prefix + configuration::SPECIAL_SUFFIX);
+	void FilterChooser::SharedData::registerAsListener(ParameterSnapshot& parameters) {
+		parameters.addParameterListener(prefix + configuration::BYPASSED_SUFFIX, configuration::ParamSuffix::BYPASSED, this);
+		parameters.addParameterListener(prefix + configuration::FILTER_TYPE_SUFFIX, configuration::ParamSuffix::FILTER_TYPE, this);
+		parameters.addParameterListener(prefix + configuration::CUTOFF_SUFFIX, configuration::ParamSuffix::CUTOFF, this);
+		modParams[CUTOFF].registerAsListener(parameters, prefix + configuration::CUTOFF_SUFFIX);
+		parameters.addParameterListener(prefix + configuration::RESONANCE_SUFFIX, configuration::ParamSuffix::RESONANCE, this);
+		modParams[RES].registerAsListener(parameters, prefix + configuration::RESONANCE_SUFFIX);
+		parameters.addParameterListener(prefix + configuration::SPECIAL_SUFFIX, configuration::ParamSuffix::SPECIAL, this);
+		modParams[SPECIAL].registerAsListener(parameters, prefix + configuration::SPECIAL_SUFFIX);
 	}
 
-	void FilterChooser::SharedData::parameterChanged(const juce::String& parameterID, float newValue) {
-		if (parameterID.endsWith(prefix + configuration::BYPASSED_SUFFIX)) {
-			bypassed = (bool)newValue;
-		}
-		else if (parameterID.endsWith(prefix + configuration::FILTER_TYPE_SUFFIX)) {
-			filterType = static_cast<FilterType>(newValue);
-		}
-		else if (parameterID.endsWith(prefix + configuration::CUTOFF_SUFFIX)) {
-			cutoff = newValue;
-		}
-		else if (parameterID.endsWith(prefix + configuration::RESONANCE_SUFFIX)) {
-			resonance = newValue;
-		}
-		else if (parameterID.endsWith(prefix + configuration::SPECIAL_SUFFIX)) {
-			special = newValue;
+	void FilterChooser::SharedData::parameterChanged(configuration::ParamSuffix suffix, float newValue) {
+		switch (suffix) {
+		case configuration::ParamSuffix::BYPASSED: bypassed = (bool)newValue; break;
+		case configuration::ParamSuffix::FILTER_TYPE: filterType = static_cast<FilterType>(newValue); break;
+		case configuration::ParamSuffix::CUTOFF: cutoff = newValue; break;
+		case configuration::ParamSuffix::RESONANCE: resonance = newValue; break;
+		case configuration::ParamSuffix::SPECIAL: special = newValue; break;
+		default: jassertfalse; break;
 		}
 	}
 
-	void FilterChooser::createFilter(FilterType type) {
+	FilterChooser::FilterChooser(SharedData* t_data) : data(t_data),
+		dummyFilter(std::make_unique<DummyFilter>(t_data)),
+		tptFilter(std::make_unique<TPTFilter>(t_data))
+	{
+		filter = dummyFilter.get();
+	}
+
+	FilterChooser::~FilterChooser() {}
+
+	void FilterChooser::activateFilter(FilterType type) {
+		// the new filter is clean already, every filter gets reset once it's faded out
+		fadingOutFilter = filter;
 		if (type == FilterType::NONE) {
-			filter = std::make_unique<DummyFilter>(data);
+			filter = dummyFilter.get();
 		}
 		else {
-			filter = std::make_unique<TPTFilter>(data);
-		}
-
-		filter->prepareUpdate();
-		if (isNoteOn) {
-			filter->noteOn();
+			filter = tptFilter.get();
 		}
+		filter->updateMode();
+		crossfade.start();
 	}
 
 	void FilterChooser::noteOn() {
 		Processor::noteOn();
-		if (filter) {
-			filter->noteOn();
-		}
+		dummyFilter->noteOn();
+		tptFilter->noteOn();
 	}
 
 	void FilterChooser::noteOff() {
 		Processor::noteOff();
-		if (filter) {
-			filter->noteOff();
-		}
+		dummyFilter->noteOff();
+		tptFilter->noteOff();
 	}
 
 	void FilterChooser::prepare(const juce::dsp::ProcessSpec& spec) {
 		data->sampleRate = spec.sampleRate;
 		data->numChannels = spec.numChannels;
-		createFilter(data->filterType);
+		// all allocations happen here, so switching types later on doesn't need any
+		dummyFilter->prepareUpdate();
+		tptFilter->prepareUpdate();
+		crossfade.prepare(spec);
+		if (data->filterType == FilterType::NONE) {
+			filter = dummyFilter.get();
+		}
+		else {
+			filter = tptFilter.get();
+		}
+		fadingOutFilter = nullptr;
 	}
 
 	void FilterChooser::reset() {
-		if (filter != nullptr) {
-			filter->reset();
+		filter->reset();
+		if (fadingOutFilter != nullptr) {
+			fadingOutFilter->reset();
+			fadingOutFilter = nullptr;
 		}
 	}
 
@@ -143,13 +154,33 @@ namespace customDsp {
 		}
 		if (data->filterType != filter->mode) {
 			if (!isSameFilter(data->filterType, filter->mode)) {
-				createFilter(data->filterType);
+				// a switch during a fade waits until it's over, otherwise the audible old filter would be reused
+				if (fadingOutFilter == nullptr) {
+					activateFilter(data->filterType);
+				}
 			}
 			else {
 				filter->updateMode();
 			}
 		}
-		return filter->process(context, workBuffers);
+		if (fadingOutFilter == nullptr) {
+			return filter->process(context, workBuffers);
+		}
+
+		// let the old filter process a copy of the input and fade over to the new one
+		auto oldSignal = crossfade.copyForOldSignal(context.getOutputBlock());
+		juce::dsp::ProcessContextNonReplacing<float> oldContext{ context.getInputBlock(), oldSignal };
+		fadingOutFilter->process(oldContext, workBuffers);
+
+		auto needMoreTime = filter->process(context, workBuffers);
+		crossfade.apply(context.getOutputBlock());
+		if (!crossfade.isActive()) {
+			// clear its state now, so activating it again later doesn't have to
+			fadingOutFilter->reset();
+			fadingOutFilter = nullptr;
+			return needMoreTime;
+		}
+		return true;
 	};
 
 	void TPTFilter::prepareUpdate() {
@@ -165,6 +196,8 @@ namespace customDsp {
 		for (auto v : { &s1, &s2 }) {
 			std::fill(v->begin(), v->end(), 0.f);
 		}
+		gRamp.reset();
+		r2Ramp.reset();
 	}
 
 	void TPTFilter::updateMode() {
@@ -188,46 +221,51 @@ namespace customDsp {
 		auto resonanceMod = data->modParams[FilterChooser::SharedData::RES].factor;
 		auto resonanceModSrc = inputBlock.getChannelPointer((size_t)data->modParams[FilterChooser::SharedData::RES].src_channel);
 
-		for (int start = 0; start < outputBlock.getNumSamples(); start += configuration::MOD_BLOCK_SIZE) {
-
-			auto end = juce::jmin(start + configuration::MOD_BLOCK_SIZE, (int)workBuffers.getNumSamples());
-
-			auto currentCutoff = juce::jmap(juce::jlimit(0.f, 1.f, cutoffBase + cutoffMod * cutoffModSrc[start]), 100.f, 18000.f);
-			float g = juce::dsp::FastMathApproximations::tan<float>(juce::MathConstants<float>::pi * currentCutoff / static_cast<float>(data->sampleRate));
-
-			auto currentResonance = juce::jmap(juce::jlimit(0.f, 1.f, resonanceBase + resonanceMod * resonanceModSrc[start]), 0.1f, 2.f);
-			float R2 = 1.0f / currentResonance;
-			float h = 1.0f / (1.0f + R2 * g + g * g);
-
-			for (int channel = 0; channel < outputBlock.getNumChannels(); channel++) {
-				auto* channelPtr = outputBlock.getChannelPointer(channel);
-
-				auto ls1 = s1[channel];
-				auto ls2 = s2[channel];
-
-				for (int sample = start; sample < end; sample++) {
-
-					auto yHP = h * (channelPtr[sample] - ls1 * (g + R2) - ls2);
-
-					auto yBP = yHP * g + ls1;
-					ls1 = yHP * g + yBP;
-
-					auto yLP = yBP * g + ls2;
-					ls2 = yBP * g + yLP;
-
-					float value = 0.f;
-					switch (mode) { //actually not slow
-					case FilterType::TPT_LPF12: value = yLP; break;
-					case FilterType::TPT_BPF12: value = yBP; break;
-					case FilterType::TPT_HPF12: value = yHP; break;
-					default: jassertfalse; break;
-					}
-					channelPtr[sample] = value;
+		jassert(workBuffers.getNumChannels() >= 2);
+		auto numSamples = (int)outputBlock.getNumSamples();
+		auto* gPtr = workBuffers.getChannelPointer(0);
+		auto* r2Ptr = workBuffers.getChannelPointer(1);
+
+		gRamp.process(gPtr, numSamples, [&](int i) {
+			auto currentCutoff = juce::jmap(juce::jlimit(0.f, 1.f, cutoffBase + cutoffMod * cutoffModSrc[i]), 100.f, 18000.f);
+			return juce::dsp::FastMathApproximations::tan<float>(juce::MathConstants<float>::pi * currentCutoff / static_cast<float>(data->sampleRate));
+			});
+		r2Ramp.process(r2Ptr, numSamples, [&](int i) {
+			auto currentResonance = juce::jmap(juce::jlimit(0.f, 1.f, resonanceBase + resonanceMod * resonanceModSrc[i]), 0.1f, 2.f);
+			return 1.0f / currentResonance;
+			});
+
+		for (int channel = 0; channel < outputBlock.getNumChannels(); channel++) {
+			auto* channelPtr = outputBlock.getChannelPointer(channel);
+
+			auto ls1 = s1[channel];
+			auto ls2 = s2[channel];
+
+			for (int sample = 0; sample < numSamples; sample++) {
+				auto g = gPtr[sample];
+				auto R2 = r2Ptr[sample];
+				auto h = 1.0f / (1.0f + R2 * g + g * g);
+
+				auto yHP = h * (channelPtr[sample] - ls1 * (g + R2) - ls2);
+
+				auto yBP = yHP * g + ls1;
+				ls1 = yHP * g + yBP;
+
+				auto yLP = yBP * g + ls2;
+				ls2 = yBP * g + yLP;
+
+				float value = 0.f;
+				switch (mode) { //actually not slow
+				case FilterType::TPT_LPF12: value = yLP; break;
+				case FilterType::TPT_BPF12: value = yBP; break;
+				case FilterType::TPT_HPF12: value = yHP; break;
+				default: jassertfalse; break;
 				}
-
-				s1[channel] = ls1;
-				s2[channel] = ls2;
+				channelPtr[sample] = value;
 			}
+
+			s1[channel] = ls1;
+			s2[channel] = ls2;
 		}
 		return isNoteOn;
 	}
@@ -24,9 +24,11 @@ namespace customDsp {
 	void replaceFilterNameWithId(juce::XmlElement& xml);
 
 	class Filter;
+	class DummyFilter;
+	class TPTFilter;
 	class LadderFilter;
 
-	class FilterChooser : public Processor {
+	class FilterChooser final : public Processor {
 	public:
 
 		inline static bool isSameFilter(FilterType a, FilterType b) {
@@ -60,9 +62,9 @@ namespace customDsp {
 
 			virtual void addParams(juce::AudioProcessorValueTreeState::ParameterLayout& layout) override;
 
-			virtual void registerAsListener(juce::AudioProcessorValueTreeState& apvts) override;
+			virtual void registerAsListener(ParameterSnapshot& parameters) override;
 
-			virtual void parameterChanged(const juce::String& parameterID, float newValue) override;
+			virtual void parameterChanged(configuration::ParamSuffix suffix, float newValue) override;
 		private:
 
 			JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SharedData)
@@ -70,10 +72,11 @@ namespace customDsp {
 
 		FilterChooser() = delete;
 
-		FilterChooser(SharedData* t_data) : data(t_data) {}
-		virtual ~FilterChooser() override {};
+		FilterChooser(SharedData* t_data);
+		virtual ~FilterChooser() override;
 
-		void createFilter(FilterType type);
+		// only swaps pointers, so it's safe to call on the audio thread
+		void activateFilter(FilterType type);
 
 		virtual void prepare(const juce::dsp::ProcessSpec& spec) override;
 
@@ -87,7 +90,13 @@ namespace customDsp {
 
 	private:
 		SharedData* data;
-		std::unique_ptr<Filter> filter;
+		// one instance of every filter implementation, created and prepared up front
+		std::unique_ptr<DummyFilter> dummyFilter;
+		std::unique_ptr<TPTFilter> tptFilter;
+		Filter* filter = nullptr;
+		// the previously active filter while it is faded out. the other filter is reset
+		Filter* fadingOutFilter = nullptr;
+		Crossfade crossfade;
 
 		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FilterChooser)
 	};
@@ -143,6 +152,8 @@ namespace customDsp {
 		void updateMode() override;
 
 		std::vector<float>s1{ 2 }, s2{ 2 };
+		// g and R2 of the filter equations, so tan is only evaluated at control points
+		ControlRamp gRamp, r2Ramp;
 
 		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TPTFilter)
 	};
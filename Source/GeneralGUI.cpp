@@ -272,10 +272,20 @@ customGui::HeaderMenu::HeaderMenu(SynthAudioProcessor& t_audioProcessor)
 		});
 
 	miscHBox.items.addArray({
+		juce::FlexItem(threadChooser).withFlex(1.f),
 		juce::FlexItem(panicButton).withFlex(1.f)
 		});
+	addAndMakeVisible(threadChooser);
 	addAndMakeVisible(panicButton);
 
+	for (int i = 1; i <= SynthAudioProcessor::getMaxRenderThreads(); i++) {
+		threadChooser.addItem(juce::String(i) + (i == 1 ? " Thread" : " Threads"), i);
+	}
+	threadChooser.setSelectedId(audioProcessor.getNumRenderThreads(), juce::NotificationType::dontSendNotification);
+	threadChooser.onChange = [this]() {
+		audioProcessor.setDefaultNumRenderThreads(threadChooser.getSelectedId());
+	};
+
 	label.setJustificationType(juce::Justification::centred);
 	label.setColour(label.textColourId, Constants::text1Colour);
 	label.setText(audioProcessor.presetName, juce::NotificationType::sendNotification);
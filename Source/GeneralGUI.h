@@ -248,6 +248,7 @@ namespace customGui {
 		Util::GridComponent buttonGrid;
 
 		MenuButton panicButton{ "DON'T PANIC!" };
+		Dropdown threadChooser{ false };
 		juce::Label label;
 		MenuButton newButton{ "New" };
 		MenuButton openButton{ "Open" };
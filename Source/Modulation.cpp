@@ -30,28 +30,20 @@ namespace customDsp {
 			stageValues[(int)Stage::RELEASE]));
 	}
 
-	 void Envelope::SharedData::registerAsListener(juce::AudioProcessorValueTreeState& apvts)  {
-		apvts.addParameterListener(prefix + configuration::ATTACK_SUFFIX, this);
-		apvts.addParameterListener(prefix + configuration::DECAY_SUFFIX, this);
-		apvts.addParameterListener(prefix + configuration::SUSTAIN_SUFFIX, this);
-		apvts.addParameterListener(prefix + configuration::RELEASE_SUFFIX, this);
+	 void Envelope::SharedData::registerAsListener(ParameterSnapshot& parameters)  {
+		parameters.addParameterListener(prefix + configuration::ATTACK_SUFFIX, configuration::ParamSuffix::ATTACK, this);
+		parameters.addParameterListener(prefix + configuration::DECAY_SUFFIX, configuration::ParamSuffix::DECAY, this);
+		parameters.addParameterListener(prefix + configuration::SUSTAIN_SUFFIX, configuration::ParamSuffix::SUSTAIN, this);
+		parameters.addParameterListener(prefix + configuration::RELEASE_SUFFIX, configuration::ParamSuffix::RELEASE, this);
 	}
 
-	 void Envelope::SharedData::parameterChanged(const juce::String& parameterID, float newValue)  {
-		if (parameterID.endsWith(configuration::ATTACK_SUFFIX)) {
-			stageValues[(int)Stage::ATTACK] = newValue;
-		}
-		else if (parameterID.endsWith(configuration::DECAY_SUFFIX)) {
-			stageValues[(int)Stage::DECAY] = newValue;
-		}
-		else if (parameterID.endsWith(configuration::SUSTAIN_SUFFIX)) {
-			stageValues[(int)Stage::SUSTAIN] = newValue;
-		}
-		else if (parameterID.endsWith(configuration::RELEASE_SUFFIX)) {
-			stageValues[(int)Stage::RELEASE] = newValue;
-		}
-		else {
-			jassertfalse;
+	 void Envelope::SharedData::parameterChanged(configuration::ParamSuffix suffix, float newValue)  {
+		switch (suffix) {
+		case configuration::ParamSuffix::ATTACK: stageValues[(int)Stage::ATTACK] = newValue; break;
+		case configuration::ParamSuffix::DECAY: stageValues[(int)Stage::DECAY] = newValue; break;
+		case configuration::ParamSuffix::SUSTAIN: stageValues[(int)Stage::SUSTAIN] = newValue; break;
+		case configuration::ParamSuffix::RELEASE: stageValues[(int)Stage::RELEASE] = newValue; break;
+		default: jassertfalse; break;
 		}
 	}
 
@@ -83,7 +75,10 @@ namespace customDsp {
 				juce::jmin((int)juce::jmin(samplesUntilTransition, samplesRemaining), configuration::MOD_BLOCK_SIZE)
 				: juce::jmin((int)samplesRemaining, configuration::MOD_BLOCK_SIZE);
 
-			outputBlock.getSubBlock(currentPos, samplesThisStep).add(level);
+			// every stage is linear, so the ramp follows it exactly instead of holding level for the whole step
+			for (size_t channel = 0; channel < outputBlock.getNumChannels(); channel++) {
+				ControlRamp::add(outputBlock.getChannelPointer(channel) + currentPos, samplesThisStep, level, summand);
+			}
 			level += summand * samplesThisStep;
 			currentPos += samplesThisStep;
 			samplesUntilTransition -= samplesThisStep;
@@ -160,31 +155,33 @@ namespace customDsp {
 			prefix + configuration::WT_SUFFIX,
 			wavetable::WavetableCache::getInstance()->getWavetableNames(),
 			0));
+
+		// read by the audio processor, which decides whether the lfo runs per voice or once for all of them
+		layout.add(std::make_unique<juce::AudioParameterBool>(
+			prefix + configuration::GLOBAL_SUFFIX,
+			prefix + configuration::GLOBAL_SUFFIX,
+			false));
 	}
 
-	 void LFO::SharedData::registerAsListener(juce::AudioProcessorValueTreeState& apvts)  {
-		apvts.addParameterListener(prefix + configuration::WT_POS_SUFFIX, this);
-		apvts.addParameterListener(prefix + configuration::RATE_SUFFIX, this);
-		apvts.addParameterListener(prefix + configuration::WT_SUFFIX, this);
+	 void LFO::SharedData::registerAsListener(ParameterSnapshot& parameters)  {
+		parameters.addParameterListener(prefix + configuration::WT_POS_SUFFIX, configuration::ParamSuffix::WT_POS, this);
+		parameters.addParameterListener(prefix + configuration::RATE_SUFFIX, configuration::ParamSuffix::RATE, this);
+		parameters.addParameterListener(prefix + configuration::WT_SUFFIX, configuration::ParamSuffix::WT, this);
+		parameters.addPublishListener(prefix + configuration::WT_SUFFIX, configuration::ParamSuffix::WT, &wtHandoff);
 	}
 
-	 void LFO::SharedData::parameterChanged(const juce::String& parameterID, float newValue)  {
-		if (parameterID.endsWith(configuration::WT_POS_SUFFIX)) {
-			wtPos = newValue;
-		}
-		else if (parameterID.endsWith(configuration::RATE_SUFFIX)) {
-			rate = newValue;
-		}
-		else if (parameterID.endsWith(configuration::WT_SUFFIX)) {
-			wt = wavetable::WavetableCache::getInstance()->getWavetable(static_cast<int>(newValue));
-		}
-		else {
-			jassertfalse;
+	 void LFO::SharedData::parameterChanged(configuration::ParamSuffix suffix, float newValue)  {
+		switch (suffix) {
+		case configuration::ParamSuffix::WT_POS: wtPos = newValue; break;
+		case configuration::ParamSuffix::RATE: rate = newValue; break;
+		case configuration::ParamSuffix::WT: wtHandoff.collect(wt); break;
+		default: jassertfalse; break;
 		}
 	}
 
 	 void LFO::prepare(const juce::dsp::ProcessSpec& spec)  {
 		data->sampleRate = spec.sampleRate;
+		data->wtHandoff.setSampleRate(spec.sampleRate);
 	};
 
 	 void LFO::reset()  {
@@ -195,7 +192,7 @@ namespace customDsp {
 	{
 		auto& outputBlock = context.getOutputBlock();
 
-		float phaseStep = (juce::MathConstants<float>::twoPi * data->rate) / (float)data->sampleRate;
+		auto phaseIncrement = PhaseAccumulator::getIncrement(data->rate, data->sampleRate);
 
 		auto& wt = data->wt->getTable(30.f); // just get a low freq table
 
@@ -209,17 +206,17 @@ namespace customDsp {
 
 		auto channel0 = wt.getReadPointer(channelIndex);
 		auto channel1 = wt.getReadPointer(channelIndex + 1);
+		const int resolution = wt.getNumSamples() - 1;
 
 		for (int start = 0; start < outputBlock.getNumSamples(); start += configuration::MOD_BLOCK_SIZE) {
 			auto length = juce::jmin(start + configuration::MOD_BLOCK_SIZE, (int)outputBlock.getNumSamples()) - start;
 			auto end = juce::jmin(start + configuration::MOD_BLOCK_SIZE, (int)workBuffers.getNumSamples());
 
 			for (int i = start; i < end; i++) {
-				auto x = phase.advance(phaseStep);
+				auto x = phase.advance(phaseIncrement);
 
-				auto scaledX = (x / juce::MathConstants<float>::twoPi) * (wt.getNumSamples() - 1);
-				int sampleIndex = static_cast<int>(scaledX);
-				auto xDelta = scaledX - sampleIndex;
+				int sampleIndex = PhaseAccumulator::getIndex(x, resolution);
+				auto xDelta = PhaseAccumulator::getFraction(x, resolution);
 				auto sample0 = juce::jmap(xDelta, channel0[sampleIndex], channel0[sampleIndex + 1]);
 				auto sample1 = juce::jmap(xDelta, channel1[sampleIndex], channel1[sampleIndex + 1]);
 
@@ -233,8 +230,7 @@ namespace customDsp {
 		return isNoteOn;
 	};
 
-	void LFO::advancePhase(float step) {
-		jassert(0.f <= step && step < juce::MathConstants<float>::twoPi);
-		phase.advance(step);
+	void LFO::advancePhase(double cycles) {
+		phase.advance(PhaseAccumulator::fromCycles(cycles));
 	}
 }
\ No newline at end of file
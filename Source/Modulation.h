@@ -27,9 +27,9 @@ namespace customDsp {
 
 			virtual void addParams(juce::AudioProcessorValueTreeState::ParameterLayout& layout) override;
 
-			virtual void registerAsListener(juce::AudioProcessorValueTreeState& apvts) override;
+			virtual void registerAsListener(ParameterSnapshot& parameters) override;
 
-			virtual void parameterChanged(const juce::String& parameterID, float newValue) override;
+			virtual void parameterChanged(configuration::ParamSuffix suffix, float newValue) override;
 		private:
 
 			JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SharedData)
@@ -79,14 +79,16 @@ namespace customDsp {
 
 			float wtPos{ 0.f }, rate{ 1.f };
 			wavetable::Wavetable::Ptr wt;
+			// lfos only read the lowest mip level
+			wavetable::WavetableHandoff wtHandoff{ wavetable::MipLevels::LOWEST_ONLY };
 
 			virtual LFO* createProcessor() override;
 
 			virtual void addParams(juce::AudioProcessorValueTreeState::ParameterLayout& layout) override;
 
-			virtual void registerAsListener(juce::AudioProcessorValueTreeState& apvts) override;
+			virtual void registerAsListener(ParameterSnapshot& parameters) override;
 
-			virtual void parameterChanged(const juce::String& parameterID, float newValue) override;
+			virtual void parameterChanged(configuration::ParamSuffix suffix, float newValue) override;
 
 		private:
 			JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SharedData)
@@ -103,12 +105,13 @@ namespace customDsp {
 
 		virtual bool process(juce::dsp::ProcessContextNonReplacing<float>& context, juce::dsp::AudioBlock<float>& workBuffers) override;
 
-		void advancePhase(float step);
+		// cycles is a fraction of a cycle, e.g. 0.25 for a quarter period
+		void advancePhase(double cycles);
 
 	private:
 		SharedData* data;
 
-		juce::dsp::Phase<float> phase;
+		PhaseAccumulator phase;
 
 		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LFO);
 	};
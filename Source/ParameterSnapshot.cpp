@@ -0,0 +1,86 @@
+#include "ParameterSnapshot.h"
+
+namespace customDsp {
+
+	ParameterSnapshot::~ParameterSnapshot()
+	{
+		for (auto* slot : slots) {
+			slot->parameter->removeListener(this);
+		}
+	}
+
+	void ParameterSnapshot::addParameterListener(const juce::String& parameterID, configuration::ParamSuffix suffix, Listener* listener)
+	{
+		getSlot(parameterID).listeners.add({ listener, suffix });
+	}
+
+	void ParameterSnapshot::addPublishListener(const juce::String& parameterID, configuration::ParamSuffix suffix, Listener* listener)
+	{
+		auto& slot = getSlot(parameterID);
+		slot.publishListeners.add({ listener, suffix });
+		publishingSlots.addIfNotAlreadyThere(&slot);
+	}
+
+	void ParameterSnapshot::update()
+	{
+		for (auto* slot : publishingSlots) {
+			for (auto& registration : slot->publishListeners) {
+				if (registration.listener->hasPendingChange()) {
+					slot->changed.store(true, std::memory_order_relaxed);
+					anyChanged.store(true, std::memory_order_relaxed);
+				}
+			}
+		}
+		if (!anyChanged.exchange(false, std::memory_order_acquire)) {
+			return;
+		}
+		for (auto* slot : slots) {
+			if (slot->changed.exchange(false, std::memory_order_acquire)) {
+				auto value = slot->value.load(std::memory_order_relaxed);
+				for (auto& registration : slot->listeners) {
+					registration.listener->parameterChanged(registration.suffix, value);
+				}
+			}
+		}
+	}
+
+	ParameterSnapshot::Slot& ParameterSnapshot::getSlot(const juce::String& parameterID)
+	{
+		auto* parameter = apvts.getParameter(parameterID);
+		jassert(parameter != nullptr);
+
+		auto parameterIndex = parameter->getParameterIndex();
+		while (slotIndices.size() <= parameterIndex) {
+			slotIndices.add(-1);
+		}
+		if (slotIndices[parameterIndex] != -1) {
+			return *slots[slotIndices[parameterIndex]];
+		}
+
+		auto* slot = slots.add(new Slot{});
+		slot->parameter = parameter;
+		slot->value.store(parameter->convertFrom0to1(parameter->getValue()));
+		slotIndices.set(parameterIndex, slots.size() - 1);
+		parameter->addListener(this);
+		return *slot;
+	}
+
+	void ParameterSnapshot::parameterValueChanged(int parameterIndex, float newValue)
+	{
+		juce::ignoreUnused(newValue);
+		auto* slot = slots[slotIndices[parameterIndex]];
+		// the parameter itself knows best, the argument isn't always its current value
+		auto value = slot->parameter->convertFrom0to1(slot->parameter->getValue());
+		slot->value.store(value, std::memory_order_relaxed);
+		for (auto& registration : slot->publishListeners) {
+			registration.listener->parameterChanged(registration.suffix, value);
+		}
+		slot->changed.store(true, std::memory_order_release);
+		anyChanged.store(true, std::memory_order_release);
+	}
+
+	void ParameterSnapshot::parameterGestureChanged(int parameterIndex, bool gestureIsStarting)
+	{
+		juce::ignoreUnused(parameterIndex, gestureIsStarting);
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Configuration.h"
+
+namespace customDsp {
+
+	// Sits between the parameters and the SharedData of the processors. Parameters can be changed from any thread,
+	// so the parameter callbacks only store the new value and flag the parameter as changed. The values are handed
+	// to the listeners on the audio thread at the start of the next block. Every block sees one consistent set of
+	// parameters and nothing the voices read changes while they are rendering.
+	// Changes are routed by index only, neither the callbacks nor update() compare strings, lock or allocate.
+	class ParameterSnapshot : private juce::AudioProcessorParameter::Listener {
+	public:
+
+		struct Listener {
+			virtual ~Listener() {}
+			// suffix tells which of the listener's parameters changed
+			virtual void parameterChanged(configuration::ParamSuffix suffix, float newValue) = 0;
+
+			// publish listeners which finish their work later on another thread return true once the result
+			// is ready. the parameter's listeners then get notified again in the next update() to pick it up
+			virtual bool hasPendingChange() { return false; }
+		};
+
+		ParameterSnapshot(juce::AudioProcessorValueTreeState& t_apvts) : apvts(t_apvts) {}
+		virtual ~ParameterSnapshot() override;
+
+		// the listener gets notified on the audio thread during update()
+		void addParameterListener(const juce::String& parameterID, configuration::ParamSuffix suffix, Listener* listener);
+
+		// the listener gets notified right away on the thread which changed the parameter, before the change
+		// is handed to the audio thread. hosts automate from the audio thread, so this has to be real time safe
+		// as well. heavier work belongs on another thread, see Listener::hasPendingChange
+		void addPublishListener(const juce::String& parameterID, configuration::ParamSuffix suffix, Listener* listener);
+
+		// hands all changes since the last call to the listeners. must only be called from the audio thread
+		void update();
+
+	private:
+
+		struct Registration {
+			Listener* listener;
+			configuration::ParamSuffix suffix;
+		};
+
+		struct Slot {
+			juce::RangedAudioParameter* parameter = nullptr;
+			juce::Array<Registration> listeners;
+			juce::Array<Registration> publishListeners;
+			std::atomic<float> value{ 0.f };
+			std::atomic<bool> changed{ false };
+		};
+
+		Slot& getSlot(const juce::String& parameterID);
+
+		virtual void parameterValueChanged(int parameterIndex, float newValue) override;
+		virtual void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override;
+
+		juce::AudioProcessorValueTreeState& apvts;
+		// only modified while registering listeners, so it's safe to read from any thread afterwards
+		juce::OwnedArray<Slot> slots;
+		// slots with publish listeners, polled for pending changes in update()
+		juce::Array<Slot*> publishingSlots;
+		// slot index for every parameter index of the processor, -1 for parameters without listeners
+		juce::Array<int> slotIndices;
+		std::atomic<bool> anyChanged{ false };
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParameterSnapshot)
+	};
+}
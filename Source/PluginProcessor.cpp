@@ -27,6 +27,14 @@ SynthAudioProcessor::SynthAudioProcessor()
 #endif
 {
 	initSynths();
+
+	juce::PropertiesFile::Options options;
+	options.applicationName = JucePlugin_Name;
+	options.folderName = JucePlugin_Name;
+	options.filenameSuffix = ".settings";
+	options.osxLibrarySubFolder = "Application Support";
+	machineSettings = std::make_unique<juce::PropertiesFile>(options);
+	setNumRenderThreads(machineSettings->getIntValue(RENDER_THREADS_KEY, 1));
 }
 
 SynthAudioProcessor::~SynthAudioProcessor()
@@ -115,6 +123,8 @@ void SynthAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 		auto prefix = configuration::LFO_PREFIX + std::to_string(lfoPos) + configuration::WT_SUFFIX;
 		apvts.getParameter(prefix)->sendValueChangedMessageToListeners(0);
 	}
+	// the first block needs the wavetables, so don't leave them to the loader thread
+	wavetable::WavetableLoader::getInstance()->loadPending();
 }
 
 void SynthAudioProcessor::releaseResources()
@@ -158,9 +168,21 @@ void SynthAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::M
 
 	buffer.clear();
 
+	// from here on the parameters stay the same until the block is done
+	parameters.update();
+
+	auto globalFx = globalFxValue.value > 0.5f;
+	synth.setGlobalFx(globalFx);
+
+	auto fxModChannels = getModChannelMask(fxModChannelValues);
+	auto voiceModChannels = getModChannelMask(modChannelValues) | (globalFx ? 0u : fxModChannels);
+	synth.setUsedModChannels(voiceModChannels, getGlobalLfoMask() & (voiceModChannels | fxModChannels));
+	synth.renderGlobalModulation(buffer.getNumSamples());
+
 	synth.renderNextBlock(buffer, midiMessages, 0, buffer.getNumSamples());
+	synth.renderGlobalFx(buffer, 0, buffer.getNumSamples());
 
-	auto masterGain = apvts.getRawParameterValue(configuration::MASTER_PREFIX + configuration::GAIN_SUFFIX)->load();
+	auto masterGain = masterGainParam->load();
 	buffer.applyGain(masterGain);
 	auto magnitude = buffer.getMagnitude(0, buffer.getNumSamples());
 	if (magnitude >= 1.f) {
@@ -211,6 +233,13 @@ void SynthAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 			wavetable::WavetableCache::getInstance()->replaceNameWithId(*xmlState);
 			customDsp::replaceFilterNameWithId(*xmlState);
 			customDsp::replaceFXNameWithId(*xmlState);
+			// presets from before the global fx bus existed rely on per-voice fx
+			auto globalFxId = configuration::MASTER_PREFIX + configuration::GLOBAL_FX_SUFFIX;
+			if (xmlState->getChildByAttribute("id", globalFxId) == nullptr) {
+				auto* paramXml = xmlState->createNewChildElement("PARAM");
+				paramXml->setAttribute("id", globalFxId);
+				paramXml->setAttribute("value", 0);
+			}
 			apvts.replaceState(juce::ValueTree::fromXml(*xmlState));
 		}
 	}
@@ -221,6 +250,59 @@ void SynthAudioProcessor::panicReset()
 	synth.reset();
 }
 
+void SynthAudioProcessor::setNumRenderThreads(int numThreads)
+{
+	numThreads = juce::jlimit(1, getMaxRenderThreads(), numThreads);
+	if (numThreads != synth.getNumRenderThreads()) {
+		synth.setNumRenderThreads(numThreads);
+	}
+}
+
+void SynthAudioProcessor::setDefaultNumRenderThreads(int numThreads)
+{
+	setNumRenderThreads(numThreads);
+	machineSettings->setValue(RENDER_THREADS_KEY, getNumRenderThreads());
+	machineSettings->saveIfNeeded();
+}
+
+int SynthAudioProcessor::getNumRenderThreads() const
+{
+	return synth.getNumRenderThreads();
+}
+
+int SynthAudioProcessor::getMaxRenderThreads()
+{
+	// more threads than voices would never get any work
+	return juce::jmin(juce::SystemStats::getNumCpus(), configuration::POLYPHONY);
+}
+
+void SynthAudioProcessor::registerSnapshotValue(SnapshotValue& value, const juce::String& parameterID,
+	configuration::ParamSuffix suffix)
+{
+	value.value = apvts.getRawParameterValue(parameterID)->load();
+	parameters.addParameterListener(parameterID, suffix, &value);
+}
+
+juce::uint32 SynthAudioProcessor::getModChannelMask(const juce::OwnedArray<SnapshotValue>& channelValues)
+{
+	juce::uint32 mask = 0;
+	for (auto* channel : channelValues) {
+		mask |= 1u << (int)channel->value;
+	}
+	return mask;
+}
+
+juce::uint32 SynthAudioProcessor::getGlobalLfoMask() const
+{
+	juce::uint32 mask = 0;
+	for (int lfo = 0; lfo < globalLfoValues.size(); lfo++) {
+		if (globalLfoValues[lfo]->value > 0.5f) {
+			mask |= 1u << (configuration::ENV_NUMBER + lfo);
+		}
+	}
+	return mask;
+}
+
 void SynthAudioProcessor::initSynths()
 {
 	// Init each synth with 'POLYPHONY' voices and one sound
@@ -230,23 +312,17 @@ void SynthAudioProcessor::initSynths()
 
 		// osc
 		for (int j = 0; j < configuration::OSC_NUMBER; j++) {
-			std::for_each(processorData[j].begin(), processorData[j].end(),
-				[&](customDsp::Processor::SharedData* data) {
-					voice->oscChains[j].addProcessor(data->createProcessor());
-				});
+			voice->oscChains[j].createProcessors(processorData[j]);
 		}
 
 		// filter
-		std::for_each(processorData[configuration::OSC_NUMBER].begin(), processorData[configuration::OSC_NUMBER].end(),
-			[&](customDsp::Processor::SharedData* data) {
-				voice->monoChain.addProcessor(data->createProcessor());
-			});
+		voice->monoChain.createProcessors(processorData[configuration::OSC_NUMBER]);
 
-		// fx & pan
-		std::for_each(processorData[configuration::OSC_NUMBER + 1].begin(), processorData[configuration::OSC_NUMBER + 1].end(),
-			[&](customDsp::Processor::SharedData* data) {
-				voice->stereoChain.addProcessor(data->createProcessor());
-			});
+		// fx
+		voice->fxChain.createProcessors(processorData[configuration::OSC_NUMBER + 1]);
+
+		// pan
+		voice->stereoChain.createProcessors(processorData[configuration::OSC_NUMBER + 2]);
 
 		// modulation
 		std::for_each(processorData[configuration::OSC_NUMBER + 3].begin(), processorData[configuration::OSC_NUMBER + 3].end(),
@@ -257,13 +333,33 @@ void SynthAudioProcessor::initSynths()
 		synth.addVoice(voice);
 	}
 
+	// one additional instance of each lfo for the global lfo mode
+	for (int lfo = 0; lfo < configuration::LFO_NUMBER; lfo++) {
+		auto* data = processorData[configuration::OSC_NUMBER + 3][configuration::ENV_NUMBER + lfo];
+		synth.globalModulationProcessors.addProcessor(data->createProcessor());
+		registerSnapshotValue(*globalLfoValues.add(new SnapshotValue{}), data->prefix + configuration::GLOBAL_SUFFIX,
+			configuration::ParamSuffix::GLOBAL);
+	}
+
+	// one additional instance of each fx for the global fx bus
+	synth.globalFxChain.createProcessors(processorData[configuration::OSC_NUMBER + 1]);
+
 	synth.addSound(new Synth::SynthSound{});
 	for (auto& dataArray : processorData) {
 		std::for_each(dataArray.begin(), dataArray.end(),
 			[&](customDsp::Processor::SharedData* data) {
-				data->registerAsListener(apvts);
+				data->registerAsListener(parameters);
 			});
 	}
+
+	for (auto* param : getParameters()) {
+		auto id = static_cast<juce::RangedAudioParameter*>(param)->paramID;
+		if (id.endsWith(configuration::MOD_CHANNEL_SUFFIX)) {
+			auto& values = id.startsWith(configuration::FX_PREFIX) ? fxModChannelValues : modChannelValues;
+			registerSnapshotValue(*values.add(new SnapshotValue{}), id, configuration::ParamSuffix::MOD_CHANNEL);
+		}
+	}
+	registerSnapshotValue(globalFxValue, configuration::MASTER_PREFIX + configuration::GLOBAL_FX_SUFFIX, configuration::ParamSuffix::GLOBAL_FX);
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout SynthAudioProcessor::createParameterDataAndLayout()
@@ -284,16 +380,14 @@ juce::AudioProcessorValueTreeState::ParameterLayout SynthAudioProcessor::createP
 		auto prefix = configuration::FILTER_PREFIX + std::to_string(i);
 		processorData[configuration::OSC_NUMBER].add(new customDsp::FilterChooser::SharedData{ prefix });
 	}
-	// stereo
+	// fx
 	for (auto i = 0; i < configuration::FX_NUMBER; i++) {
 		auto prefix = configuration::FX_PREFIX + std::to_string(i);
 		processorData[configuration::OSC_NUMBER + 1].add(new customDsp::FXChooser::SharedData{ prefix });
 	}
 
-	processorData[configuration::OSC_NUMBER + 1].add(new customDsp::Pan::SharedData{ configuration::PAN_PREFIX });
-
-	// Master
-	//processorData[configuration::OSC_NUMBER + 2].add(new customDsp::Gain::SharedData{ configuration::MASTER_PREFIX });
+	// stereo
+	processorData[configuration::OSC_NUMBER + 2].add(new customDsp::Pan::SharedData{ configuration::PAN_PREFIX });
 
 	// Create Processor::SharedData for the modulation processors in the right order
 	for (auto i = 0; i < configuration::ENV_NUMBER; i++) {
@@ -322,6 +416,10 @@ juce::AudioProcessorValueTreeState::ParameterLayout SynthAudioProcessor::createP
 		configuration::MASTER_PREFIX + configuration::GAIN_SUFFIX,
 		juce::NormalisableRange<float>(0.0f, 1.0f, 0.001f, 1.f),
 		0.5f));
+	layout.add(std::make_unique<juce::AudioParameterBool>(
+		configuration::MASTER_PREFIX + configuration::GLOBAL_FX_SUFFIX,
+		configuration::MASTER_PREFIX + configuration::GLOBAL_FX_SUFFIX,
+		true));
 
 	return layout;
 }
@@ -65,23 +65,65 @@ public:
 
 	void panicReset();
 
+	// number of threads (including the audio thread) used to render the voices.
+	// it depends on the machine, so it's kept in the machine settings instead of the plugin state
+	void setNumRenderThreads(int numThreads);
+	// also stores numThreads in the machine settings, so new instances start with it
+	void setDefaultNumRenderThreads(int numThreads);
+	int getNumRenderThreads() const;
+	static int getMaxRenderThreads();
+
 	juce::String presetName{ "Untitled" };
 
 private:
 
 	void initSynths();
 
+	// a parameter as seen by the processors in the current block, only changes in parameters.update()
+	struct SnapshotValue : public customDsp::ParameterSnapshot::Listener {
+		float value = 0.f;
+
+		virtual void parameterChanged(configuration::ParamSuffix suffix, float newValue) override {
+			juce::ignoreUnused(suffix);
+			value = newValue;
+		}
+	};
+
+	// lets value follow parameterID, starting out with the parameter's current value
+	void registerSnapshotValue(SnapshotValue& value, const juce::String& parameterID, configuration::ParamSuffix suffix);
+
+	// bit i is set if any of the modulation targets reads from mod channel i
+	static juce::uint32 getModChannelMask(const juce::OwnedArray<SnapshotValue>& channelValues);
+	// bit i is set if mod channel i belongs to an lfo in global mode
+	juce::uint32 getGlobalLfoMask() const;
+
 	Synth::Synth synth;
+
+	inline static const juce::String RENDER_THREADS_KEY{ "RenderThreads" };
+	std::unique_ptr<juce::PropertiesFile> machineSettings;
+
+	// the channel choice of every modulation target. fx targets are kept separately,
+	// because voices don't run their fx while the global fx bus is active.
+	// the masks come from the same snapshot as the routing the voices use, so both always match
+	juce::OwnedArray<SnapshotValue> modChannelValues;
+	juce::OwnedArray<SnapshotValue> fxModChannelValues;
+	juce::OwnedArray<SnapshotValue> globalLfoValues;
+	SnapshotValue globalFxValue;
 	// first OSC_NUMBER entries hold osc specific data, 
 	// the next entry holds mono processor/filter data,
-	// the next entry holds stereo processor(fx & pan) data
-	// the second to last entry holds master data (master gain)
+	// the next entry holds fx data (used per voice or on the global fx bus)
+	// the second to last entry holds stereo processor(pan) data
 	// and the last entry holds modulation parameters (envs and lfos)
-	std::vector<juce::OwnedArray<customDsp::Processor::SharedData>> processorData{configuration::OSC_NUMBER+4};
+	juce::OwnedArray<customDsp::Processor::SharedData> processorData[configuration::OSC_NUMBER + 4];
 	
 	juce::AudioProcessorValueTreeState::ParameterLayout createParameterDataAndLayout();
 
 	juce::AudioProcessorValueTreeState apvts{ *this, nullptr, configuration::VALUE_TREE_IDENTIFIER, createParameterDataAndLayout() };
+	// hands parameter changes to the processorData at the start of each block
+	customDsp::ParameterSnapshot parameters{ apvts };
+
+	// looked up once, so processBlock doesn't have to build any ids
+	std::atomic<float>* masterGainParam = apvts.getRawParameterValue(configuration::MASTER_PREFIX + configuration::GAIN_SUFFIX);
 
 	juce::PerformanceCounter performanceCounter{ "ProcessingBlockCounter",500 };
 	//==============================================================================
@@ -0,0 +1,120 @@
+#include "RenderPool.h"
+#include <thread>
+#if JUCE_INTEL
+#include <immintrin.h>
+#endif
+
+namespace {
+
+	// spins until condition() is true. the pause frees the core for a hyperthread sibling and every
+	// now and then the scheduler gets a chance to run a preempted worker on this core
+	template<typename Condition>
+	void spinUntil(Condition condition)
+	{
+		for (int spins = 1; !condition(); spins++) {
+#if JUCE_INTEL
+			_mm_pause();
+#elif JUCE_ARM && JUCE_MSVC
+			__yield();
+#elif JUCE_ARM
+			__asm__ __volatile__("yield");
+#endif
+			if (spins % 64 == 0) {
+				std::this_thread::yield();
+			}
+		}
+	}
+}
+
+namespace Synth {
+
+	RenderPool::RenderPool(int numThreads)
+	{
+		jassert(numThreads >= 1);
+		for (int i = 1; i < numThreads; i++) {
+			workers.add(new Worker(*this, i));
+		}
+		// the audio thread waits for claimed jobs, so the workers need the same priority as the audio thread
+		for (auto* worker : workers) {
+#if JUCE_MAJOR_VERSION >= 7
+			if (!worker->startRealtimeThread(juce::Thread::RealtimeOptions{}.withPriority(10))) {
+				worker->startThread(juce::Thread::Priority::highest);
+			}
+#else
+			worker->startThread(10);
+#endif
+		}
+	}
+
+	RenderPool::~RenderPool()
+	{
+		for (auto* worker : workers) {
+			worker->signalThreadShouldExit();
+			worker->wakeUp.signal();
+		}
+		for (auto* worker : workers) {
+			worker->stopThread(1000);
+		}
+	}
+
+	int RenderPool::getNumThreads() const
+	{
+		return workers.size() + 1;
+	}
+
+	void RenderPool::run(int numJobs, Job& job)
+	{
+		if (numJobs <= 0) {
+			return;
+		}
+
+		currentJob = &job;
+		currentNumJobs = numJobs;
+		finishedJobs.store(0);
+		nextJob.store(0);
+		roundActive.store(true);
+
+		// the calling thread works as well, so we need at most numJobs - 1 workers
+		auto workersToWake = juce::jmin(workers.size(), numJobs - 1);
+		for (int i = 0; i < workersToWake; i++) {
+			workers.getUnchecked(i)->wakeUp.signal();
+		}
+
+		claimJobs();
+
+		// the remaining jobs are being processed right now, so this won't spin for long
+		spinUntil([&] { return finishedJobs.load(std::memory_order_acquire) >= numJobs; });
+
+		roundActive.store(false);
+		spinUntil([&] { return busyWorkers.load() == 0; });
+	}
+
+	void RenderPool::work()
+	{
+		busyWorkers.fetch_add(1);
+		if (roundActive.load()) {
+			juce::ScopedNoDenormals noDenormals;
+			claimJobs();
+		}
+		busyWorkers.fetch_sub(1);
+	}
+
+	void RenderPool::claimJobs()
+	{
+		for (int index = nextJob.fetch_add(1); index < currentNumJobs; index = nextJob.fetch_add(1)) {
+			currentJob->runJob(index);
+			finishedJobs.fetch_add(1, std::memory_order_release);
+		}
+	}
+
+	void RenderPool::Worker::run()
+	{
+		while (!threadShouldExit()) {
+			wakeUp.wait(-1);
+			if (threadShouldExit()) {
+				return;
+			}
+			pool.work();
+		}
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace Synth {
+
+	// Pool of worker threads which lets the audio thread spread independent jobs (e.g. voices) over several cores.
+	// All threads are created and destroyed outside of the audio thread. Jobs are claimed through a shared atomic
+	// counter, so whichever thread is free takes the next job and the calling thread takes over all jobs
+	// a worker didn't wake up in time for. run() never allocates and never waits for a sleeping worker.
+	class RenderPool {
+	public:
+
+		struct Job {
+			virtual ~Job() {}
+			// may be called concurrently for different indices
+			virtual void runJob(int index) = 0;
+		};
+
+		// numThreads includes the calling thread, so 1 means no worker threads at all
+		RenderPool(int numThreads);
+		~RenderPool();
+
+		int getNumThreads() const;
+
+		// runs job.runJob(i) for all i in [0, numJobs) and returns once all of them have finished
+		void run(int numJobs, Job& job);
+
+	private:
+
+		class Worker : public juce::Thread {
+		public:
+			Worker(RenderPool& t_pool, int index) : juce::Thread("RenderWorker " + juce::String(index)), pool(t_pool) {}
+			virtual ~Worker() override {}
+
+			virtual void run() override;
+
+			juce::WaitableEvent wakeUp;
+
+		private:
+			RenderPool& pool;
+
+			JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Worker)
+		};
+
+		void work();
+		void claimJobs();
+
+		juce::OwnedArray<Worker> workers;
+
+		Job* currentJob = nullptr;
+		int currentNumJobs = 0;
+		std::atomic<int> nextJob{ 0 };
+		std::atomic<int> finishedJobs{ 0 };
+
+		// makes sure no worker from a previous round is still looking at the job counters
+		// when the next round is set up
+		std::atomic<bool> roundActive{ false };
+		std::atomic<int> busyWorkers{ 0 };
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RenderPool)
+	};
+}
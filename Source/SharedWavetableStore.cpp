@@ -0,0 +1,567 @@
+#include "SharedWavetableStore.h"
+#include <map>
+
+#if JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+#else
+ #include <cerrno>
+ #include <fcntl.h>
+ #include <signal.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <unistd.h>
+#endif
+
+namespace wavetable {
+
+	namespace {
+		// room for the header, a multiple of the page size and of the allocation granularity on windows,
+		// so the data can be mapped on its own
+		constexpr size_t HEADER_BYTES = 65536;
+		// references per block, a process which finds no free slot uses its own copy of the table
+		constexpr int MAX_HOLDERS = 1024;
+		// how often a waiting process checks whether the creator is still alive
+		constexpr juce::uint32 CREATOR_CHECK_INTERVAL_MS = 50;
+
+		juce::String getOsName(const juce::String& name)
+		{
+#if JUCE_WINDOWS
+			return "Local\\" + name;
+#else
+			return "/" + name;
+#endif
+		}
+
+		juce::uint32 getProcessId()
+		{
+#if JUCE_WINDOWS
+			return (juce::uint32)GetCurrentProcessId();
+#else
+			return (juce::uint32)getpid();
+#endif
+		}
+
+		bool isProcessAlive(juce::uint32 processId)
+		{
+#if JUCE_WINDOWS
+			auto process = OpenProcess(SYNCHRONIZE, FALSE, (DWORD)processId);
+			if (process == nullptr) {
+				// it exists but belongs to someone else
+				return GetLastError() == ERROR_ACCESS_DENIED;
+			}
+			auto alive = WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+			CloseHandle(process);
+			return alive;
+#else
+			return kill((pid_t)processId, 0) == 0 || errno == EPERM;
+#endif
+		}
+	}
+
+	struct SharedMemory::Header {
+		// 0 while the block is being created or removed, nobody may join it then
+		std::atomic<juce::int32> refCount;
+		std::atomic<juce::uint32> ready;
+		juce::uint64 dataSize;
+		// if the creator dies before markReady the block is removed by whoever waits for it
+		juce::uint32 creatorId;
+		// set once by the process which removes an abandoned block
+		std::atomic<juce::uint32> removed;
+		// the process id behind every reference, so the references of crashed processes can be given back
+		std::atomic<juce::uint32> holders[MAX_HOLDERS];
+	};
+	// the header is used by several processes at once
+	static_assert(std::atomic<juce::int32>::is_always_lock_free && std::atomic<juce::uint32>::is_always_lock_free);
+
+	void SharedMemory::initAsCreator(size_t t_dataSize)
+	{
+		static_assert(sizeof(Header) <= HEADER_BYTES);
+		// the new block is filled with zeros, so nobody can join it before the reference count is set
+		dataSize = t_dataSize;
+		header->dataSize = t_dataSize;
+		header->creatorId = getProcessId();
+		holderSlot = 0;
+		header->holders[0].store(header->creatorId, std::memory_order_relaxed);
+		header->refCount.store(1, std::memory_order_release);
+	}
+
+	bool SharedMemory::join()
+	{
+		auto count = header->refCount.load(std::memory_order_acquire);
+		do {
+			if (count <= 0) {
+				return false;
+			}
+		} while (!header->refCount.compare_exchange_weak(count, count + 1, std::memory_order_acq_rel));
+
+		const auto processId = getProcessId();
+		for (int slot = 0; slot < MAX_HOLDERS; slot++) {
+			juce::uint32 expected = 0;
+			if (header->holders[slot].compare_exchange_strong(expected, processId, std::memory_order_acq_rel)) {
+				holderSlot = slot;
+				return true;
+			}
+		}
+		if (header->refCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			removeName();
+		}
+		return false;
+	}
+
+	void SharedMemory::leave()
+	{
+		releaseDeadHolders();
+		header->holders[holderSlot].store(0, std::memory_order_release);
+		holderSlot = -1;
+		// an abandoned block has been removed already and its count doesn't mean anything anymore
+		if (header->removed.load(std::memory_order_acquire) != 0) {
+			return;
+		}
+		if (header->refCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			removeName();
+		}
+	}
+
+	void SharedMemory::releaseDeadHolders()
+	{
+		// we hold a reference ourselves, so the count can't drop to 0 here
+		for (auto& holder : header->holders) {
+			auto processId = holder.load(std::memory_order_acquire);
+			if (processId != 0 && !isProcessAlive(processId)
+				&& holder.compare_exchange_strong(processId, 0, std::memory_order_acq_rel)) {
+				header->refCount.fetch_sub(1, std::memory_order_acq_rel);
+			}
+		}
+	}
+
+	bool SharedMemory::isAbandoned() const
+	{
+		return header->ready.load(std::memory_order_acquire) == 0 && !isProcessAlive(header->creatorId);
+	}
+
+	void SharedMemory::removeAbandoned()
+	{
+		// every process waiting for the block gets here, only one of them removes it
+		juce::uint32 expected = 0;
+		if (header->removed.compare_exchange_strong(expected, 1, std::memory_order_acq_rel)) {
+			header->refCount.store(0, std::memory_order_release);
+			removeName();
+		}
+	}
+
+#if JUCE_WINDOWS
+
+	std::unique_ptr<SharedMemory> SharedMemory::create(const juce::String& name, size_t dataSize)
+	{
+		const auto totalSize = (juce::uint64)(HEADER_BYTES + dataSize);
+		auto handle = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+			(DWORD)(totalSize >> 32), (DWORD)totalSize, getOsName(name).toWideCharPointer());
+		if (handle == nullptr) {
+			return nullptr;
+		}
+		if (GetLastError() == ERROR_ALREADY_EXISTS) {
+			CloseHandle(handle);
+			return nullptr;
+		}
+		std::unique_ptr<SharedMemory> memory{ new SharedMemory(name) };
+		memory->mappingHandle = handle;
+		memory->header = static_cast<Header*>(MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, HEADER_BYTES));
+		if (memory->header == nullptr) {
+			return nullptr;
+		}
+		memory->dataSize = dataSize;
+		if (!memory->mapData(true)) {
+			return nullptr;
+		}
+		memory->initAsCreator(dataSize);
+		return memory;
+	}
+
+	std::unique_ptr<SharedMemory> SharedMemory::open(const juce::String& name)
+	{
+		auto handle = OpenFileMappingW(FILE_MAP_ALL_ACCESS, FALSE, getOsName(name).toWideCharPointer());
+		if (handle == nullptr) {
+			return nullptr;
+		}
+		std::unique_ptr<SharedMemory> memory{ new SharedMemory(name) };
+		memory->mappingHandle = handle;
+		memory->header = static_cast<Header*>(MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, HEADER_BYTES));
+		if (memory->header == nullptr || !memory->join()) {
+			return nullptr;
+		}
+
+		memory->dataSize = (size_t)memory->header->dataSize;
+		if (!memory->mapData(false)) {
+			return nullptr;
+		}
+		return memory;
+	}
+
+	SharedMemory::~SharedMemory()
+	{
+		if (holderSlot >= 0) {
+			leave();
+		}
+		if (data != nullptr) {
+			UnmapViewOfFile(data);
+		}
+		if (header != nullptr) {
+			UnmapViewOfFile(header);
+		}
+		if (mappingHandle != nullptr) {
+			CloseHandle(mappingHandle);
+		}
+	}
+
+	void SharedMemory::removeName()
+	{
+		// windows removes the mapping itself when the last handle is closed, crashed processes included
+	}
+
+	bool SharedMemory::mapData(bool writable)
+	{
+		data = MapViewOfFile(mappingHandle, writable ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, (DWORD)HEADER_BYTES, dataSize);
+		return data != nullptr;
+	}
+
+	void SharedMemory::markReady()
+	{
+		DWORD oldProtection;
+		VirtualProtect(data, dataSize, PAGE_READONLY, &oldProtection);
+		header->ready.store(1, std::memory_order_release);
+	}
+
+#else
+
+	std::unique_ptr<SharedMemory> SharedMemory::create(const juce::String& name, size_t dataSize)
+	{
+		auto fd = shm_open(getOsName(name).toRawUTF8(), O_RDWR | O_CREAT | O_EXCL, 0600);
+		if (fd == -1) {
+			return nullptr;
+		}
+		if (ftruncate(fd, (off_t)(HEADER_BYTES + dataSize)) != 0) {
+			close(fd);
+			shm_unlink(getOsName(name).toRawUTF8());
+			return nullptr;
+		}
+		std::unique_ptr<SharedMemory> memory{ new SharedMemory(name) };
+		auto* mappedHeader = mmap(nullptr, HEADER_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		memory->dataSize = dataSize;
+		memory->data = mmap(nullptr, dataSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, (off_t)HEADER_BYTES);
+		close(fd);
+		if (memory->data == MAP_FAILED) {
+			memory->data = nullptr;
+		}
+		if (mappedHeader == MAP_FAILED || memory->data == nullptr) {
+			if (mappedHeader != MAP_FAILED) {
+				munmap(mappedHeader, HEADER_BYTES);
+			}
+			shm_unlink(getOsName(name).toRawUTF8());
+			return nullptr;
+		}
+		memory->header = static_cast<Header*>(mappedHeader);
+		memory->initAsCreator(dataSize);
+		return memory;
+	}
+
+	std::unique_ptr<SharedMemory> SharedMemory::open(const juce::String& name)
+	{
+		auto fd = shm_open(getOsName(name).toRawUTF8(), O_RDWR, 0);
+		if (fd == -1) {
+			return nullptr;
+		}
+		struct stat info;
+		// the creator might not have sized it yet
+		if (fstat(fd, &info) != 0 || (size_t)info.st_size <= HEADER_BYTES) {
+			close(fd);
+			return nullptr;
+		}
+		auto* mappedHeader = mmap(nullptr, HEADER_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (mappedHeader == MAP_FAILED) {
+			close(fd);
+			return nullptr;
+		}
+		std::unique_ptr<SharedMemory> memory{ new SharedMemory(name) };
+		memory->header = static_cast<Header*>(mappedHeader);
+		if (!memory->join()) {
+			close(fd);
+			return nullptr;
+		}
+		memory->dataSize = (size_t)memory->header->dataSize;
+		if ((size_t)info.st_size != HEADER_BYTES + memory->dataSize) {
+			close(fd);
+			return nullptr;
+		}
+		auto* mappedData = mmap(nullptr, memory->dataSize, PROT_READ, MAP_SHARED, fd, (off_t)HEADER_BYTES);
+		close(fd);
+		if (mappedData == MAP_FAILED) {
+			return nullptr;
+		}
+		memory->data = mappedData;
+		return memory;
+	}
+
+	SharedMemory::~SharedMemory()
+	{
+		// the last process removes the name, the pages go away once nobody has them mapped anymore
+		if (holderSlot >= 0) {
+			leave();
+		}
+		if (data != nullptr) {
+			munmap(data, dataSize);
+		}
+		if (header != nullptr) {
+			munmap(header, HEADER_BYTES);
+		}
+	}
+
+	void SharedMemory::removeName()
+	{
+		shm_unlink(getOsName(name).toRawUTF8());
+	}
+
+	void SharedMemory::markReady()
+	{
+		mprotect(data, dataSize, PROT_READ);
+		header->ready.store(1, std::memory_order_release);
+	}
+
+#endif
+
+	void* SharedMemory::getData() const
+	{
+		return data;
+	}
+
+	size_t SharedMemory::getDataSize() const
+	{
+		return dataSize;
+	}
+
+	bool SharedMemory::waitUntilReady(int timeoutMs) const
+	{
+		const auto start = juce::Time::getMillisecondCounter();
+		auto lastCreatorCheck = start;
+		while (header->ready.load(std::memory_order_acquire) == 0) {
+			const auto now = juce::Time::getMillisecondCounter();
+			if (now - start > (juce::uint32)timeoutMs) {
+				return false;
+			}
+			if (now - lastCreatorCheck >= CREATOR_CHECK_INTERVAL_MS) {
+				if (isAbandoned()) {
+					return false;
+				}
+				lastCreatorCheck = now;
+			}
+			juce::Thread::sleep(1);
+		}
+		return true;
+	}
+
+	Wavetable* SharedWavetableStore::getOrGenerate(const juce::String& wtName, double sampleRate, MipLevels levels,
+		const std::function<Wavetable*()>& generate)
+	{
+		const auto key = getKey(wtName, sampleRate, levels);
+		std::unique_ptr<Wavetable> generated;
+		// the table in the shared layout
+		juce::MemoryBlock data;
+
+		for (int attempt = 0; attempt < MAX_ATTEMPTS; attempt++) {
+			if (auto memory = SharedMemory::open(key)) {
+				if (!memory->waitUntilReady(READY_TIMEOUT_MS)) {
+					// the creator crashed before it was done, so the table gets made again
+					if (memory->isAbandoned()) {
+						memory->removeAbandoned();
+						continue;
+					}
+					// a creator which is alive but never finishes leaves us with a local table
+					break;
+				}
+				if (auto* wt = attach(std::move(memory), wtName, sampleRate, levels)) {
+					return wt;
+				}
+				break;
+			}
+
+			// nobody has it yet, so this process makes it. factory tables only have to be decompressed
+			if (data.isEmpty() && !readFactoryTable(wtName, sampleRate, levels, data)) {
+				generated.reset(generate());
+				if (generated == nullptr || !toData(*generated, data)) {
+					break;
+				}
+			}
+			if (auto memory = SharedMemory::create(key, data.getSize())) {
+				std::memcpy(memory->getData(), data.getData(), data.getSize());
+				memory->markReady();
+				if (auto* wt = attach(std::move(memory), wtName, sampleRate, levels)) {
+					return wt;
+				}
+				break;
+			}
+			// another process is just creating or removing it
+			juce::Thread::sleep(1);
+		}
+		return generated != nullptr ? generated.release() : generate();
+	}
+
+	juce::String SharedWavetableStore::getKey(const juce::String& wtName, double sampleRate, MipLevels levels)
+	{
+		// generated tables only depend on these, so they identify the content
+		juce::String description;
+		description << wtName << "|" << sampleRate << "|" << static_cast<int>(levels) << "|" << LAYOUT_VERSION
+			<< "|" << WavetableCache::GENERATOR_VERSION;
+		return "SynthWT-" + juce::String::toHexString(description.hashCode64());
+	}
+
+	size_t SharedWavetableStore::getPoolOffset(const Layout& layout)
+	{
+		auto offset = sizeof(Layout) + (size_t)layout.numLevels * (size_t)layout.numChannels * sizeof(juce::int32);
+		// keep the channels aligned for the interpolation kernels
+		return (offset + 63) & ~(size_t)63;
+	}
+
+	size_t SharedWavetableStore::getDataSize(const Layout& layout)
+	{
+		return getPoolOffset(layout) + (size_t)layout.numPoolChannels * (size_t)layout.numSamples * sizeof(float);
+	}
+
+	bool SharedWavetableStore::collectChannels(const Wavetable& source, Layout& layout,
+		juce::Array<const float*>& pool, juce::Array<int>& indices)
+	{
+		auto& firstTable = source.tables[0];
+		layout = { LAYOUT_MAGIC, source.getNumLevels(), firstTable.getNumChannels(), firstTable.getNumSamples(), 0 };
+
+		std::map<const float*, int> poolIndices;
+		for (int level = 0; level < layout.numLevels; level++) {
+			auto& table = source.tables[level];
+			// all levels of a shared table have the same size
+			if (table.getNumChannels() != layout.numChannels || table.getNumSamples() != layout.numSamples) {
+				return false;
+			}
+			for (int channel = 0; channel < layout.numChannels; channel++) {
+				auto* channelPtr = table.getReadPointer(channel);
+				auto found = poolIndices.find(channelPtr);
+				if (found == poolIndices.end()) {
+					found = poolIndices.emplace(channelPtr, pool.size()).first;
+					pool.add(channelPtr);
+				}
+				indices.add(found->second);
+			}
+		}
+		layout.numPoolChannels = pool.size();
+		return true;
+	}
+
+	bool SharedWavetableStore::toData(const Wavetable& source, juce::MemoryBlock& data)
+	{
+		Layout layout;
+		juce::Array<const float*> pool;
+		juce::Array<int> indices;
+		if (!collectChannels(source, layout, pool, indices)) {
+			return false;
+		}
+		data.setSize(getDataSize(layout), true);
+		auto* dataPtr = static_cast<char*>(data.getData());
+		std::memcpy(dataPtr, &layout, sizeof(Layout));
+
+		auto* indexPtr = reinterpret_cast<juce::int32*>(dataPtr + sizeof(Layout));
+		for (auto index : indices) {
+			*indexPtr++ = index;
+		}
+
+		auto* channelPtr = reinterpret_cast<float*>(dataPtr + getPoolOffset(layout));
+		for (auto* channel : pool) {
+			std::memcpy(channelPtr, channel, (size_t)layout.numSamples * sizeof(float));
+			channelPtr += layout.numSamples;
+		}
+		return true;
+	}
+
+	bool SharedWavetableStore::readFactoryTable(const juce::String& wtName, double sampleRate, MipLevels levels,
+		juce::MemoryBlock& data)
+	{
+		auto* entry = factory::findEntry(wtName, sampleRate);
+		// tables of another generator are stale, the data was built before the generator changed
+		if (entry == nullptr || entry->layoutVersion != LAYOUT_VERSION
+			|| entry->generatorVersion != WavetableCache::GENERATOR_VERSION) {
+			return false;
+		}
+		juce::MemoryInputStream compressed{ entry->data, (size_t)entry->size, false };
+		juce::GZIPDecompressorInputStream stream{ compressed };
+
+		Layout layout;
+		if (stream.read(&layout, sizeof(Layout)) != (int)sizeof(Layout) || layout.magic != LAYOUT_MAGIC
+			|| layout.numLevels != 11 || layout.numChannels < 2 || layout.numSamples < 2 || layout.numPoolChannels < 1) {
+			jassertfalse;
+			return false;
+		}
+		juce::HeapBlock<juce::int32> indices((size_t)layout.numLevels * (size_t)layout.numChannels);
+		const auto indicesSize = (int)(sizeof(juce::int32) * (size_t)layout.numLevels * (size_t)layout.numChannels);
+		if (stream.read(indices.get(), indicesSize) != indicesSize) {
+			jassertfalse;
+			return false;
+		}
+		const auto poolOffset = getPoolOffset(layout);
+
+		if (levels == MipLevels::LOWEST_ONLY) {
+			// the channels of the lowest level come first in the pool, so the rest never gets decompressed
+			int numPoolChannels = 0;
+			for (int channel = 0; channel < layout.numChannels; channel++) {
+				numPoolChannels = juce::jmax(numPoolChannels, indices[channel] + 1);
+			}
+			layout.numLevels = 1;
+			layout.numPoolChannels = numPoolChannels;
+		}
+
+		data.setSize(getDataSize(layout), true);
+		auto* dataPtr = static_cast<char*>(data.getData());
+		std::memcpy(dataPtr, &layout, sizeof(Layout));
+		std::memcpy(dataPtr + sizeof(Layout), indices.get(), sizeof(juce::int32) * (size_t)layout.numLevels * (size_t)layout.numChannels);
+
+		stream.skipNextBytes((juce::int64)(poolOffset - sizeof(Layout)) - indicesSize);
+		const auto poolSize = (int)((size_t)layout.numPoolChannels * (size_t)layout.numSamples * sizeof(float));
+		if (stream.read(dataPtr + getPoolOffset(layout), poolSize) != poolSize) {
+			jassertfalse;
+			data.reset();
+			return false;
+		}
+		return true;
+	}
+
+	Wavetable* SharedWavetableStore::attach(std::unique_ptr<SharedMemory> memory, const juce::String& wtName,
+		double sampleRate, MipLevels levels)
+	{
+		if (memory->getDataSize() < sizeof(Layout)) {
+			return nullptr;
+		}
+		auto* dataPtr = static_cast<char*>(memory->getData());
+		Layout layout;
+		std::memcpy(&layout, dataPtr, sizeof(Layout));
+		if (layout.magic != LAYOUT_MAGIC || layout.numLevels < 1 || layout.numLevels > 11
+			|| layout.numChannels < 2 || layout.numSamples < 2 || getDataSize(layout) != memory->getDataSize()) {
+			return nullptr;
+		}
+
+		auto* indexPtr = reinterpret_cast<const juce::int32*>(dataPtr + sizeof(Layout));
+		// the mapping is read only, but the tables are only ever handed out as const
+		auto* pool = reinterpret_cast<float*>(dataPtr + getPoolOffset(layout));
+
+		std::unique_ptr<Wavetable> wt{ new Wavetable(wtName, sampleRate, levels) };
+		juce::HeapBlock<float*> channelPtrs(layout.numChannels);
+		for (int level = 0; level < layout.numLevels; level++) {
+			for (int channel = 0; channel < layout.numChannels; channel++) {
+				auto index = *indexPtr++;
+				if (index < 0 || index >= layout.numPoolChannels) {
+					return nullptr;
+				}
+				channelPtrs[channel] = pool + (size_t)index * (size_t)layout.numSamples;
+			}
+			wt->tables[level] = juce::AudioBuffer<float>{ channelPtrs, layout.numChannels, layout.numSamples };
+		}
+		wt->sharedMemory = std::move(memory);
+		return wt.release();
+	}
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Wavetable.h"
+#include "FactoryWavetables.h"
+
+namespace wavetable {
+
+	// A named block of memory which every process of the user can map. A small header in front of the data
+	// holds a reference count across processes and a ready flag. Only the process which creates a block writes
+	// to it, everyone else maps the data read only. The block goes away once the last process lets go of it.
+	// Every reference is tagged with its process id, so references of crashed processes are given back
+	// and a block whose creator crashed before it was ready can be removed.
+	class SharedMemory {
+	public:
+		~SharedMemory();
+
+		// nullptr if a block with this name exists already or the os doesn't let us create one
+		static std::unique_ptr<SharedMemory> create(const juce::String& name, size_t dataSize);
+		// nullptr if there is no block with this name, or it's just being created or removed
+		static std::unique_ptr<SharedMemory> open(const juce::String& name);
+
+		// only writable by the creator and only until markReady()
+		void* getData() const;
+		size_t getDataSize() const;
+
+		// called by the creator once the data is complete, makes the data read only
+		void markReady();
+		// false if the creator didn't finish within timeoutMs or died before it finished
+		bool waitUntilReady(int timeoutMs) const;
+
+		// true if the block isn't ready and its creator doesn't exist anymore
+		bool isAbandoned() const;
+		// removes the name of an abandoned block, so it can be created again. the block stays mapped
+		void removeAbandoned();
+
+	private:
+		struct Header;
+
+		SharedMemory(const juce::String& t_name) : name(t_name) {}
+
+		// maps the data behind the header, the header has to be mapped already
+		bool mapData(bool writable);
+
+		void initAsCreator(size_t t_dataSize);
+		// takes a reference and a holder slot, false if the block can't be joined
+		bool join();
+		// gives back the reference taken by create or join
+		void leave();
+		// gives back the references of processes which don't exist anymore
+		void releaseDeadHolders();
+		void removeName();
+
+		juce::String name;
+		Header* header = nullptr;
+		void* data = nullptr;
+		size_t dataSize = 0;
+		// -1 while this doesn't hold a reference
+		int holderSlot = -1;
+#if JUCE_WINDOWS
+		void* mappingHandle = nullptr;
+#endif
+
+		JUCE_DECLARE_NON_COPYABLE(SharedMemory)
+	};
+
+
+	// Keeps generated wavetables in shared memory, so all plugin instances in all processes use a single copy of
+	// each table instead of generating their own. A table is keyed by everything it's generated from, which
+	// makes the key a hash of its content. Channels shared between mip levels stay shared in memory.
+	class SharedWavetableStore {
+	public:
+		// returns the shared table if any process made it already. otherwise the table is generated, published
+		// and the published copy is returned. if shared memory isn't available the generated table is returned
+		static Wavetable* getOrGenerate(const juce::String& wtName, double sampleRate, MipLevels levels,
+			const std::function<Wavetable*()>& generate);
+
+		// writes source in the layout used in shared memory and for the factory tables.
+		// false if the levels of source differ in size
+		static bool toData(const Wavetable& source, juce::MemoryBlock& data);
+
+		// part of the key, so a newer version never picks up a table written by an older one
+		static constexpr int LAYOUT_VERSION = 1;
+
+	private:
+		// at the start of the data, followed by the pool index of every channel of every level and the pool
+		struct Layout {
+			juce::uint32 magic;
+			juce::int32 numLevels;
+			juce::int32 numChannels;
+			juce::int32 numSamples;
+			juce::int32 numPoolChannels;
+		};
+		static constexpr juce::uint32 LAYOUT_MAGIC = 0x53575453; // "STWS"
+
+		// how long to wait for another process which is just creating a table
+		static constexpr int READY_TIMEOUT_MS = 5000;
+		static constexpr int MAX_ATTEMPTS = 100;
+
+		static juce::String getKey(const juce::String& wtName, double sampleRate, MipLevels levels);
+		static size_t getPoolOffset(const Layout& layout);
+		static size_t getDataSize(const Layout& layout);
+
+		// the distinct channels of source in pool and the pool index of every channel of every level in indices
+		static bool collectChannels(const Wavetable& source, Layout& layout,
+			juce::Array<const float*>& pool, juce::Array<int>& indices);
+		// decompresses the factory table for wtName at sampleRate, only up to the levels asked for.
+		// false if there is none
+		static bool readFactoryTable(const juce::String& wtName, double sampleRate, MipLevels levels, juce::MemoryBlock& data);
+		// nullptr if memory doesn't hold a valid table
+		static Wavetable* attach(std::unique_ptr<SharedMemory> memory, const juce::String& wtName, double sampleRate, MipLevels levels);
+	};
+}
@@ -123,6 +123,9 @@ customGui::OscModule::OscModule(SynthAudioProcessor& audioProcessor, int id) :
 		juce::GridItem(gainModKnob).withArea(Property("knobRow1-start"), Property(3)),
 		juce::GridItem(gainModSrcChooser).withArea(Property("modSrcRow-start"), Property(3)),
 
+		juce::GridItem(qualityLabel).withArea(Property("knobRow0-start"), Property(4)),
+		juce::GridItem(qualityChooser).withArea(Property("knobRow0-start"), Property(4)),
+
 		juce::GridItem(envLabel).withArea(Property("knobRow1-start"), Property(4)),
 		juce::GridItem(envChooser).withArea(Property("modSrcRow-start"), Property(4)),
 		});
@@ -144,6 +147,11 @@ customGui::OscModule::OscModule(SynthAudioProcessor& audioProcessor, int id) :
 	addAndMakeVisible(envLabel);
 	addAndMakeVisible(envChooser);
 
+	qualityLabel.setColour(qualityLabel.textColourId, Constants::text1Colour);
+	qualityLabel.setJustificationType(juce::Justification::centredBottom);
+	addAndMakeVisible(qualityLabel);
+	addAndMakeVisible(qualityChooser);
+
 	// VALUE TREE ATTACHMENTS
 	auto& apvts = audioProcessor.getApvts();
 
@@ -182,6 +190,9 @@ customGui::OscModule::OscModule(SynthAudioProcessor& audioProcessor, int id) :
 	comboBoxAttachments.add(new ComboBoxAttachment(apvts,
 		prefix + configuration::ENV_SUFFIX + configuration::MOD_CHANNEL_SUFFIX,
 		envChooser));
+
+	qualityChooser.addItemList(customDsp::INTERPOLATION_QUALITY_NAMES, 1);
+	comboBoxAttachments.add(new ComboBoxAttachment(apvts, prefix + configuration::INTERPOLATION_SUFFIX, qualityChooser));
 }
 
 void customGui::OscModule::resized()
@@ -189,6 +200,11 @@ void customGui::OscModule::resized()
 	SynthModule::resized();
 	auto proportion = NamedKnob::KNOB_FLEX / (NamedKnob::LABEL_FLEX + NamedKnob::KNOB_FLEX);
 	envLabel.setBounds(envLabel.getBounds().withTrimmedTop(envLabel.proportionOfHeight(proportion)));
+
+	// label and chooser share a knob cell, laid out like envLabel and envChooser
+	auto qualityBounds = qualityChooser.getBounds();
+	qualityChooser.setBounds(qualityBounds.removeFromBottom(envChooser.getHeight()));
+	qualityLabel.setBounds(qualityBounds.withTrimmedTop(qualityBounds.proportionOfHeight(proportion)));
 }
 
 customGui::FilterModule::FilterModule(SynthAudioProcessor& audioProcessor, int id) :
@@ -411,10 +427,12 @@ customGui::LFOModule::LFOModule(SynthAudioProcessor& audioProcessor, int id)
 	grid.items.addArray({
 		juce::GridItem(wtPosKnob).withArea(Property("knobRow0-start"), Property(1)),
 		juce::GridItem(rateKnob).withArea(Property("knobRow0-start"), Property(2)),
+		juce::GridItem(globalButton).withArea(Property("knobRow1-start"), Property(1)),
 		});
 
 	addAndMakeVisible(wtPosKnob);
 	addAndMakeVisible(rateKnob);
+	addAndMakeVisible(globalButton);
 
 	// VALUE TREE ATTACHMENTS
 	auto& apvts = audioProcessor.getApvts();
@@ -424,6 +442,8 @@ customGui::LFOModule::LFOModule(SynthAudioProcessor& audioProcessor, int id)
 
 	sliderAttachments.add(new SliderAttachment(apvts, prefix + configuration::WT_POS_SUFFIX, wtPosKnob.knob));
 	sliderAttachments.add(new SliderAttachment(apvts, prefix + configuration::RATE_SUFFIX, rateKnob.knob));
+	globalButton.setColour(juce::ToggleButton::textColourId, Constants::text0Colour);
+	buttonAttachments.add(new ButtonAttachment(apvts, prefix + configuration::GLOBAL_SUFFIX, globalButton));
 }
 
 customGui::PanModule::PanModule(SynthAudioProcessor& audioProcessor, int id)
@@ -519,10 +539,12 @@ customGui::MasterModule::MasterModule(SynthAudioProcessor& t_audioProcessor, int
 	auto& grid = gridComponent.grid;
 	grid.items.addArray({
 		juce::GridItem(masterKnob).withArea(Property("knobRow0-start"), Property(1)),
+		juce::GridItem(globalFxButton).withArea(Property("knobRow1-start"), Property(1)),
 		juce::GridItem(levelDisplay).withArea(Property("knobRow0-start"), Property(2), Property("modSrcRow-end"), Property(3)),
 		});
 
 	addAndMakeVisible(masterKnob);
+	addAndMakeVisible(globalFxButton);
 	addAndMakeVisible(levelDisplay);
 
 	// VALUE TREE ATTACHMENTS
@@ -534,5 +556,7 @@ customGui::MasterModule::MasterModule(SynthAudioProcessor& t_audioProcessor, int
 	auto& apvts = audioProcessor.getApvts();
 
 	sliderAttachments.add(new SliderAttachment(apvts, prefix + configuration::GAIN_SUFFIX, masterKnob.knob));
+	globalFxButton.setColour(juce::ToggleButton::textColourId, Constants::text0Colour);
+	buttonAttachments.add(new ButtonAttachment(apvts, prefix + configuration::GLOBAL_FX_SUFFIX, globalFxButton));
 }
 
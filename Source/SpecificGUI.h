@@ -58,6 +58,9 @@ namespace customGui {
 		juce::Label envLabel{ "","Env" };
 		ModSrcChooser envChooser;
 
+		juce::Label qualityLabel{ "","Quality" };
+		ModSrcChooser qualityChooser;
+
 	private:
 
 		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OscModule)
@@ -149,6 +152,7 @@ namespace customGui {
 	protected:
 		NamedKnob wtPosKnob{ "WtPos" };
 		NamedKnob rateKnob{ "Rate" };
+		juce::ToggleButton globalButton{ "Global" };
 
 	private:
 
@@ -200,6 +204,7 @@ namespace customGui {
 		SynthAudioProcessor& audioProcessor;
 		LevelDisplay levelDisplay{};
 		NamedKnob masterKnob{ "Master" };
+		juce::ToggleButton globalFxButton{ "Global FX" };
 
 	private:
 
@@ -5,18 +5,188 @@ namespace Synth {
 	void Synth::prepare(const juce::dsp::ProcessSpec& spec)
 	{
 		setCurrentPlaybackSampleRate(spec.sampleRate);
-		for (auto voice : voices) {
-			dynamic_cast<SynthVoice*>(voice)->prepare(spec);
+
+		globalModBlock = juce::dsp::AudioBlock<float>(globalModHeapBlock,
+			configuration::LFO_NUMBER + 1 // + 1 for empty channel
+			+ customDsp::WORK_BUFFERS,
+			spec.maximumBlockSize);
+		globalModBlock.clear();
+		globalModulationProcessors.prepare(spec);
+		sharedModChannels.fill(nullptr);
+		globalFxModChannels.fill(nullptr);
+
+		for (auto* voice : voices) {
+			toSynthVoice(voice)->prepare(spec);
+			toSynthVoice(voice)->setSharedModChannels(sharedModChannels.data());
+		}
+
+		tmpAudioBlock = juce::dsp::AudioBlock<float>(heapBlock,
+			customDsp::WORK_BUFFERS,
+			spec.maximumBlockSize);
+		tmpAudioBlock.clear();
+		globalFxChain.prepare(spec);
+
+		activeVoices.ensureStorageAllocated(voices.size());
+	}
+
+	SynthVoice* Synth::toSynthVoice(juce::SynthesiserVoice* voice)
+	{
+		jassert(dynamic_cast<SynthVoice*>(voice) != nullptr);
+		return static_cast<SynthVoice*>(voice);
+	}
+
+	void Synth::setUsedModChannels(juce::uint32 mask, juce::uint32 globalMask)
+	{
+		// envelopes are always voice specific
+		globalModChannels = globalMask & ~((1u << configuration::ENV_NUMBER) - 1);
+		for (auto* voice : voices) {
+			toSynthVoice(voice)->setUsedModChannels(mask, globalModChannels);
+		}
+	}
+
+	void Synth::renderGlobalModulation(int numSamples)
+	{
+		auto lfoBlock = globalModBlock.getSubsetChannelBlock(0, configuration::LFO_NUMBER + 1)
+			.getSubBlock(0, numSamples);
+		auto workBlock = globalModBlock.getSubsetChannelBlock(configuration::LFO_NUMBER + 1, customDsp::WORK_BUFFERS)
+			.getSubBlock(0, numSamples);
+
+		auto activeLfos = globalModChannels >> configuration::ENV_NUMBER;
+		for (int lfo = 0; lfo < configuration::LFO_NUMBER; lfo++) {
+			if ((activeLfos >> lfo) & 1u) {
+				lfoBlock.getSingleChannelBlock((size_t)lfo).clear();
+			}
+		}
+		globalModulationProcessors.setActiveProcessors(activeLfos);
+
+		juce::dsp::ProcessContextNonReplacing<float> modulationContext{ juce::dsp::AudioBlock<float>{}, lfoBlock };
+		globalModulationProcessors.process(modulationContext, workBlock);
+	}
+
+	void Synth::setNumRenderThreads(int numThreads)
+	{
+		auto newPool = std::make_unique<RenderPool>(numThreads);
+		{
+			const juce::ScopedLock sl(lock);
+			std::swap(renderPool, newPool);
+		}
+		// the old workers are stopped here, outside of the lock, so the audio thread doesn't have to wait for them
+	}
+
+	int Synth::getNumRenderThreads() const
+	{
+		const juce::ScopedLock sl(lock);
+		return renderPool->getNumThreads();
+	}
+
+	void Synth::renderVoices(juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples)
+	{
+		// every voice renders into its own tmpAudioBlock, the results are summed up in voice order afterwards
+		// so the output doesn't depend on which thread finished first
+		activeVoices.clearQuick();
+		for (auto* voice : voices) {
+			if (voice->isVoiceActive()) {
+				activeVoices.add(toSynthVoice(voice));
+			}
+		}
+		if (activeVoices.isEmpty()) {
+			return;
+		}
+
+		// let the voices read the part of the global lfos which belongs to this sub block
+		for (int lfo = 0; lfo < configuration::LFO_NUMBER; lfo++) {
+			sharedModChannels[(size_t)(configuration::ENV_NUMBER + lfo)] = globalModBlock.getChannelPointer((size_t)lfo) + startSample;
+		}
+
+		// fill the simd lanes, but not at the cost of leaving threads without work
+		auto numThreads = renderPool->getNumThreads();
+		jobGroupSize = juce::jlimit(1, customDsp::InterpolationOsc::BATCH_SIZE, (activeVoices.size() + numThreads - 1) / numThreads);
+
+		jobNumChannels = outputAudio.getNumChannels();
+		jobNumSamples = numSamples;
+		renderPool->run((activeVoices.size() + jobGroupSize - 1) / jobGroupSize, *this);
+
+		for (auto* voice : activeVoices) {
+			voice->addRenderedBlock(outputAudio, startSample, numSamples);
+		}
+	}
+
+	void Synth::runJob(int index)
+	{
+		auto first = index * jobGroupSize;
+		auto numVoices = juce::jmin(jobGroupSize, activeVoices.size() - first);
+		auto* group = activeVoices.begin() + first;
+
+		for (int i = 0; i < numVoices; i++) {
+			group[i]->beginRender(jobNumChannels, jobNumSamples);
+		}
+
+		// the same osc of all voices in the group is rendered at once, one voice per simd lane
+		customDsp::InterpolationOsc::BatchItem items[customDsp::InterpolationOsc::BATCH_SIZE];
+		for (int osc = 0; osc < configuration::OSC_NUMBER; osc++) {
+			for (int i = 0; i < numVoices; i++) {
+				items[i] = group[i]->getOscBatchItem(osc);
+			}
+			customDsp::InterpolationOsc::processBatch(items, numVoices);
+			for (int i = 0; i < numVoices; i++) {
+				group[i]->finishOscChain(osc, items[i].needMoreTime);
+			}
+		}
+
+		for (int i = 0; i < numVoices; i++) {
+			group[i]->endRender();
 		}
 	}
 
 	void Synth::reset()
 	{
 		for (auto* voice : voices) {
-			dynamic_cast<SynthVoice*>(voice)->reset();
+			toSynthVoice(voice)->reset();
+		}
+		globalFxChain.reset();
+		globalModulationProcessors.reset();
+	}
+
+	void Synth::setGlobalFx(bool shouldBeGlobal)
+	{
+		if (globalFx == shouldBeGlobal) {
+			return;
+		}
+		globalFx = shouldBeGlobal;
+		// don't let an old tail leak into the output when switching back
+		globalFxChain.reset();
+		for (auto* voice : voices) {
+			toSynthVoice(voice)->setGlobalFx(shouldBeGlobal);
 		}
 	}
 
+	void Synth::renderGlobalFx(juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples)
+	{
+		if (!globalFx) {
+			return;
+		}
+
+		auto outputBlock = juce::dsp::AudioBlock<float>{ outputBuffer }.getSubBlock((size_t)startSample, (size_t)numSamples);
+
+		auto workBlock = tmpAudioBlock.getSubsetChannelBlock(0, customDsp::WORK_BUFFERS)
+			.getSubBlock(0, numSamples);
+		workBlock.clear();
+
+		// envelopes and voice specific lfos don't exist here, so the global fx only see global lfos
+		// and empty modulation channels otherwise
+		auto emptyChannel = globalModBlock.getChannelPointer((size_t)configuration::LFO_NUMBER) + startSample;
+		for (int channel = 0; channel <= configuration::EMPTY_MOD_CHANNEL; channel++) {
+			auto lfo = channel - configuration::ENV_NUMBER;
+			globalFxModChannels[(size_t)channel] = ((globalModChannels >> channel) & 1u) ?
+				globalModBlock.getChannelPointer((size_t)lfo) + startSample
+				: emptyChannel;
+		}
+		juce::dsp::AudioBlock<float> inputBlock{ globalFxModChannels.data(), globalFxModChannels.size(), (size_t)numSamples };
+
+		juce::dsp::ProcessContextNonReplacing<float> fxContext{ inputBlock, outputBlock };
+		globalFxChain.process(fxContext, workBlock);
+	}
+
 	void SynthVoice::prepare(const juce::dsp::ProcessSpec& spec)
 	{
 		tmpAudioBlock = juce::dsp::AudioBlock<float>(heapBlock,
@@ -24,14 +194,40 @@ namespace Synth {
 			+ modulationProcessors.size()
 			+ customDsp::WORK_BUFFERS + 1, // + 1 for empty channel
 			spec.maximumBlockSize);
+		// unused modulation channels are never cleared again, so they have to start out silent
+		tmpAudioBlock.clear();
+		dirtyModChannels = 0;
+		// one processor per mod channel
+		jassert(modulationProcessors.size() == configuration::EMPTY_MOD_CHANNEL);
+		modChannels.fill(nullptr);
 		for (auto& p : oscChains) {
 			p.prepare(spec);
 		}
 		monoChain.prepare(spec);
+		fxChain.prepare(spec);
 		stereoChain.prepare(spec);
 		modulationProcessors.prepare(spec);
 	}
 
+	void SynthVoice::setGlobalFx(bool shouldBeGlobal)
+	{
+		if (globalFx != shouldBeGlobal) {
+			fxChain.reset();
+		}
+		globalFx = shouldBeGlobal;
+	}
+
+	void SynthVoice::setUsedModChannels(juce::uint32 mask, juce::uint32 globalMask)
+	{
+		usedModChannels = mask;
+		globalModChannels = globalMask;
+	}
+
+	void SynthVoice::setSharedModChannels(float* const* channels)
+	{
+		sharedModChannels = channels;
+	}
+
 	bool SynthVoice::canPlaySound(juce::SynthesiserSound*)
 	{
 		return true;
@@ -43,12 +239,13 @@ namespace Synth {
 		auto freq = static_cast<float>(juce::MidiMessage::getMidiNoteInHertz(midiNoteNumber))
 			* pitchWheelToFactor(currentPitchWheelPosition);
 		for (auto& p : oscChains) {
-			auto osc = dynamic_cast<customDsp::InterpolationOsc*>(p.getProcessor(0));
-			osc->setFrequency(freq, true);
-			osc->setVelocity(velocity);
+			auto& osc = p.get<0>();
+			osc.setFrequency(freq, true);
+			osc.setVelocity(velocity);
 			p.noteOn();
 		}
 		monoChain.noteOn();
+		fxChain.noteOn();
 		stereoChain.noteOn();
 		modulationProcessors.noteOn();
 	}
@@ -60,6 +257,7 @@ namespace Synth {
 			p.noteOff();
 		}
 		monoChain.noteOff();
+		fxChain.noteOff();
 		stereoChain.noteOff();
 		modulationProcessors.noteOff();
 		if (!allowTailOff) {
@@ -73,8 +271,7 @@ namespace Synth {
 		auto freq = static_cast<float>(juce::MidiMessage::getMidiNoteInHertz(midiNoteNumber)) 
 					* pitchWheelToFactor(newPitchWheelValue);
 		for (auto& p : oscChains) {
-			auto osc = dynamic_cast<customDsp::InterpolationOsc*>(p.getProcessor(0));
-			osc->setFrequency(freq, false);
+			p.get<0>().setFrequency(freq, false);
 		}
 	}
 
@@ -89,64 +286,127 @@ namespace Synth {
 			return;
 		}
 
-		auto numChannels = outputBuffer.getNumChannels();
+		render(outputBuffer.getNumChannels(), numSamples);
+		addRenderedBlock(outputBuffer, startSample, numSamples);
+	}
+
+	void SynthVoice::render(int numChannels, int numSamples)
+	{
+		beginRender(numChannels, numSamples);
+
+		// process oscillators and add results to next context
+		juce::dsp::ProcessContextNonReplacing<float> oscContext{ inputBlock, tmpMonoBlock };
+		for (auto& p : oscChains) {
+			needMoreTime |= p.process(oscContext, workBlock);
+			monoBlock.add(tmpMonoBlock);
+			tmpMonoBlock.clear();
+		}
+
+		endRender();
+	}
+
+	void SynthVoice::beginRender(int numChannels, int numSamples)
+	{
+		renderNumChannels = numChannels;
 
 		// prepare temporary AudioBlocks to be used as buffers
-		auto outputBlock = tmpAudioBlock.getSubsetChannelBlock(0, numChannels)
+		outputBlock = tmpAudioBlock.getSubsetChannelBlock(0, numChannels)
 			.getSubBlock(0, numSamples);
 		outputBlock.clear();
-		auto monoBlock = outputBlock.getSingleChannelBlock(0);
-		auto tmpMonoBlock = outputBlock.getSingleChannelBlock(1);
+		monoBlock = outputBlock.getSingleChannelBlock(0);
+		tmpMonoBlock = outputBlock.getSingleChannelBlock(1);
 
-		auto workBlock = tmpAudioBlock.getSubsetChannelBlock(numChannels, customDsp::WORK_BUFFERS)
+		workBlock = tmpAudioBlock.getSubsetChannelBlock(numChannels, customDsp::WORK_BUFFERS)
 			.getSubBlock(0, numSamples);
 		workBlock.clear();
 
-		auto inputBlock = tmpAudioBlock.getSubsetChannelBlock(numChannels + customDsp::WORK_BUFFERS,
+		auto ownModBlock = tmpAudioBlock.getSubsetChannelBlock(numChannels + customDsp::WORK_BUFFERS,
 			modulationProcessors.size() + 1)
-			.getSubBlock(0, numSamples);;
-		inputBlock.clear();
+			.getSubBlock(0, numSamples);
+
+		// only clear channels which get filled now or still hold something from the last block.
+		// the empty channel is never written to
+		auto ownModChannels = usedModChannels & ~globalModChannels;
+		auto channelsToClear = ownModChannels | dirtyModChannels;
+		for (int channel = 0; channel < modulationProcessors.size(); channel++) {
+			if ((channelsToClear >> channel) & 1u) {
+				ownModBlock.getSingleChannelBlock((size_t)channel).clear();
+			}
+		}
+		dirtyModChannels = ownModChannels;
+		modulationProcessors.setActiveProcessors(ownModChannels);
+
+		// global channels are read from the synth instead, the voice's processors never write to them
+		for (int channel = 0; channel <= modulationProcessors.size(); channel++) {
+			auto isShared = channel < modulationProcessors.size() && ((globalModChannels >> channel) & 1u);
+			modChannels[(size_t)channel] = isShared ? sharedModChannels[channel] : ownModBlock.getChannelPointer((size_t)channel);
+		}
+		inputBlock = juce::dsp::AudioBlock<float>(modChannels.data(), modChannels.size(), (size_t)numSamples);
 
 		juce::dsp::ProcessContextNonReplacing<float> modulationContext{ juce::dsp::AudioBlock<float>{},inputBlock };
-		juce::dsp::ProcessContextNonReplacing<float> oscContext{ inputBlock, tmpMonoBlock };
-		juce::dsp::ProcessContextNonReplacing<float> monoContext{ inputBlock, monoBlock };
-		juce::dsp::ProcessContextNonReplacing<float> stereoContext{ inputBlock, outputBlock };
 
 		// fill inputBlock with modulation signals
-		bool needMoreTime = modulationProcessors.process(modulationContext, workBlock);
+		needMoreTime = modulationProcessors.process(modulationContext, workBlock);
+	}
 
-		// process oscillators and add results to next context
-		for (auto& p : oscChains) {
-			needMoreTime |= p.process(oscContext, workBlock);
-			monoBlock.add(tmpMonoBlock);
-			tmpMonoBlock.clear();
-		}
+	customDsp::InterpolationOsc::BatchItem SynthVoice::getOscBatchItem(int oscIndex)
+	{
+		customDsp::InterpolationOsc::BatchItem item;
+		item.osc = &oscChains[oscIndex].get<0>();
+		item.inputBlock = inputBlock;
+		item.outputBlock = tmpMonoBlock;
+		item.workBuffers = workBlock;
+		return item;
+	}
+
+	void SynthVoice::finishOscChain(int oscIndex, bool oscNeedsMoreTime)
+	{
+		juce::dsp::ProcessContextNonReplacing<float> oscContext{ inputBlock, tmpMonoBlock };
+		needMoreTime |= oscNeedsMoreTime;
+		needMoreTime |= oscChains[oscIndex].processFrom<1>(oscContext, workBlock);
+		monoBlock.add(tmpMonoBlock);
+		tmpMonoBlock.clear();
+	}
+
+	void SynthVoice::endRender()
+	{
+		juce::dsp::ProcessContextNonReplacing<float> monoContext{ inputBlock, monoBlock };
+		juce::dsp::ProcessContextNonReplacing<float> stereoContext{ inputBlock, outputBlock };
 
 		//// process mono stuff (filters)
 		needMoreTime |= monoChain.process(monoContext, workBlock);
 
 		// copy the mono signal to all other channels (which should only be one)
-		for (int channel = 1; channel < numChannels; channel++) {
+		for (int channel = 1; channel < renderNumChannels; channel++) {
 			outputBlock.getSingleChannelBlock(channel).copyFrom(monoBlock);
 		}
-		//// process stereo stuff (fx)
+		//// process stereo stuff (fx & pan)
+		if (!globalFx) {
+			needMoreTime |= fxChain.process(stereoContext, workBlock);
+		}
 		needMoreTime |= stereoChain.process(stereoContext, workBlock);
 
-		// add result from temporary block to the output buffer
-		juce::dsp::AudioBlock<float>{outputBuffer}.getSubBlock((size_t)startSample, (size_t)numSamples)
-			.add(outputBlock.getSubsetChannelBlock(0, numChannels));
-
+		// the rendered block stays untouched by reset, so it can still be added afterwards
 		if (!needMoreTime) {
 			reset();
 		}
 	}
 
+	void SynthVoice::addRenderedBlock(juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples)
+	{
+		// add result from temporary block to the output buffer
+		auto numChannels = outputBuffer.getNumChannels();
+		juce::dsp::AudioBlock<float>{outputBuffer}.getSubBlock((size_t)startSample, (size_t)numSamples)
+			.add(tmpAudioBlock.getSubsetChannelBlock(0, numChannels).getSubBlock(0, numSamples));
+	}
+
 	void SynthVoice::reset()
 	{
 		for (auto& p : oscChains) {
 			p.reset();
 		}
 		monoChain.reset();
+		fxChain.reset();
 		stereoChain.reset();
 		modulationProcessors.reset();
 		clearCurrentNote();
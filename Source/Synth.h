@@ -2,19 +2,84 @@
 
 #include <JuceHeader.h>
 #include "DSP.h"
+#include "Filter.h"
+#include "FX.h"
+#include "RenderPool.h"
 
 namespace Synth
 {
+	class SynthVoice;
 
-	class Synth : public juce::Synthesiser {
+	// the fixed layout of a voice. the oscillator is always the first processor of its chain
+	using OscChain = customDsp::StaticChain<customDsp::InterpolationOsc, customDsp::Gain>;
+	using FilterChain = customDsp::RepeatedChain<customDsp::FilterChooser, configuration::FILTER_NUMBER>::Type;
+	using FxChain = customDsp::RepeatedChain<customDsp::FXChooser, configuration::FX_NUMBER>::Type;
+	using StereoChain = customDsp::StaticChain<customDsp::Pan>;
+
+	class Synth : public juce::Synthesiser, private RenderPool::Job {
 		using Synthesiser::Synthesiser;
 	public:
 		virtual ~Synth() override {};
 
 		void prepare(const juce::dsp::ProcessSpec& spec);
 		void reset();
+
+		// switches between running the fx once per voice and once on the summed output of all voices
+		void setGlobalFx(bool shouldBeGlobal);
+		bool isGlobalFx() const { return globalFx; }
+
+		// applies the global fx chain to the summed voice output; does nothing in per-voice mode
+		void renderGlobalFx(juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples);
+
+		// bit i is set if anything reads modulation channel i, envelopes and lfos without a bit set are skipped.
+		// channels in globalMask are computed once by globalModulationProcessors and shared by all voices
+		void setUsedModChannels(juce::uint32 mask, juce::uint32 globalMask);
+
+		// runs the global lfos for the whole block, has to be called before renderNextBlock
+		void renderGlobalModulation(int numSamples);
+
+		// must not be called from the audio thread
+		void setNumRenderThreads(int numThreads);
+		int getNumRenderThreads() const;
+
+		// fx which run on the summed output of all voices when global fx are enabled
+		FxChain globalFxChain;
+
+		// free running lfos, processor i belongs to mod channel ENV_NUMBER + i
+		customDsp::SplitProcessor globalModulationProcessors;
+
+	protected:
+		virtual void renderVoices(juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples) override;
+
 	private:
 
+		virtual void runJob(int index) override;
+
+		// all voices are SynthVoices, only debug builds check it
+		static SynthVoice* toSynthVoice(juce::SynthesiserVoice* voice);
+
+		std::unique_ptr<RenderPool> renderPool = std::make_unique<RenderPool>(1);
+		juce::Array<SynthVoice*> activeVoices;
+		int jobNumChannels = 0;
+		int jobNumSamples = 0;
+		// number of voices per job, their oscillators get rendered in one batch
+		int jobGroupSize = 1;
+
+		bool globalFx = false;
+
+		// holds the work buffers for the global fx chain
+		juce::HeapBlock<char> heapBlock;
+		juce::dsp::AudioBlock<float> tmpAudioBlock;
+
+		juce::uint32 globalModChannels = 0;
+		// holds the output of the global lfos, an empty channel and their work buffers
+		juce::HeapBlock<char> globalModHeapBlock;
+		juce::dsp::AudioBlock<float> globalModBlock;
+		// per mod channel, the global lfo output for the part of the block currently rendered by the voices
+		std::array<float*, configuration::EMPTY_MOD_CHANNEL> sharedModChannels{};
+		// mod channels of the global fx, either a global lfo or the empty channel
+		std::array<float*, configuration::EMPTY_MOD_CHANNEL + 1> globalFxModChannels{};
+
 		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Synth)
 	};
 
@@ -33,11 +98,34 @@ namespace Synth
 		virtual void controllerMoved(int controllerNumber, int newControllerValue) override;
 		virtual void renderNextBlock(juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples) override;
 
+		// renders the next numSamples into the voice's own buffer without touching any shared state,
+		// so different voices can be rendered concurrently
+		void render(int numChannels, int numSamples);
+		// adds the block from the last call to render to the outputBuffer
+		void addRenderedBlock(juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples);
+
+		// the steps of render, split up so the oscillators of several voices can be rendered as one batch:
+		// beginRender, then getOscBatchItem and finishOscChain for every osc, then endRender
+		void beginRender(int numChannels, int numSamples);
+		customDsp::InterpolationOsc::BatchItem getOscBatchItem(int oscIndex);
+		// processes the rest of the osc chain once its oscillator has been rendered
+		void finishOscChain(int oscIndex, bool oscNeedsMoreTime);
+		void endRender();
+
 		void reset();
 
-		std::vector<customDsp::ProcessorChain> oscChains{ configuration::OSC_NUMBER };
-		customDsp::ProcessorChain monoChain;
-		customDsp::ProcessorChain stereoChain;
+		void setGlobalFx(bool shouldBeGlobal);
+
+		void setUsedModChannels(juce::uint32 mask, juce::uint32 globalMask);
+
+		// channels[i] is read instead of the voice's own modulation channel i while bit i of the global mask is set
+		void setSharedModChannels(float* const* channels);
+
+		OscChain oscChains[configuration::OSC_NUMBER];
+		FilterChain monoChain;
+		// only processed while the fx don't run globally
+		FxChain fxChain;
+		StereoChain stereoChain;
 		customDsp::SplitProcessor modulationProcessors;
 
 	private:
@@ -47,9 +135,25 @@ namespace Synth
 			return std::exp2f(2 * normalizedPos / 12.f);
 		}
 
+		bool globalFx = false;
+
 		juce::HeapBlock<char> heapBlock;
 		juce::dsp::AudioBlock<float> tmpAudioBlock;
 
+		// views into tmpAudioBlock for the block currently being rendered
+		juce::dsp::AudioBlock<float> outputBlock, monoBlock, tmpMonoBlock, workBlock, inputBlock;
+		int renderNumChannels = 0;
+		bool needMoreTime = false;
+
+		juce::uint32 usedModChannels = 0;
+		juce::uint32 globalModChannels = 0;
+		// channels which were written to during the last block, all others are known to be silent
+		juce::uint32 dirtyModChannels = 0;
+		// owned by the synth, only ever read by the voice
+		float* const* sharedModChannels = nullptr;
+		// channel pointers of inputBlock, a mix of own and shared channels
+		std::array<float*, configuration::EMPTY_MOD_CHANNEL + 1> modChannels{};
+
 		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SynthVoice)
 	};
 
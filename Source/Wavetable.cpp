@@ -1,16 +1,112 @@
 
 #include "Wavetable.h"
+#include "SharedWavetableStore.h"
+#include <set>
 
 namespace wavetable {
 
 	JUCE_IMPLEMENT_SINGLETON(WavetableCache);
+	JUCE_IMPLEMENT_SINGLETON(WavetableLoader);
+	JUCE_IMPLEMENT_SINGLETON(GeneratorPool);
+
+	namespace {
+		// the usual crc-32 (ieee 802.3)
+		struct Crc32Table {
+			juce::uint32 values[256];
+
+			constexpr Crc32Table() : values() {
+				for (juce::uint32 i = 0; i < 256; i++) {
+					auto value = i;
+					for (int bit = 0; bit < 8; bit++) {
+						value = (value & 1) != 0 ? 0xedb88320u ^ (value >> 1) : value >> 1;
+					}
+					values[i] = value;
+				}
+			}
+		};
+		constexpr Crc32Table CRC32_TABLE;
+
+		juce::uint32 crc32(const void* data, size_t size, juce::uint32 crc = 0)
+		{
+			auto* bytes = static_cast<const juce::uint8*>(data);
+			crc = ~crc;
+			for (size_t i = 0; i < size; i++) {
+				crc = CRC32_TABLE.values[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+			}
+			return ~crc;
+		}
+
+		size_t getLevelBytes(int numChannels, int numSamples)
+		{
+			return (size_t)numChannels * (size_t)numSamples * sizeof(float);
+		}
+
+		size_t alignUp(size_t offset, size_t alignment)
+		{
+			return (offset + alignment - 1) / alignment * alignment;
+		}
+
+		// FileCodec::COMPRESSED: neighbouring samples mostly share sign, exponent and upper mantissa bits,
+		// so xoring them leaves zeros in the high bytes. splitting the words into planes puts those zeros next
+		// to each other, where deflate finds them. lossless, since xor and the planes are simply undone
+		void compressLevel(const juce::AudioBuffer<float>& table, juce::MemoryBlock& compressed)
+		{
+			const auto numSamples = (size_t)table.getNumSamples();
+			const auto numWords = (size_t)table.getNumChannels() * numSamples;
+			juce::HeapBlock<juce::uint8> planes(4 * numWords);
+			for (int channel = 0; channel < table.getNumChannels(); channel++) {
+				auto* samples = table.getReadPointer(channel);
+				juce::uint32 previous = 0;
+				for (size_t i = 0; i < numSamples; i++) {
+					juce::uint32 word;
+					std::memcpy(&word, samples + i, sizeof(word));
+					auto delta = word ^ previous;
+					previous = word;
+					auto index = (size_t)channel * numSamples + i;
+					for (size_t plane = 0; plane < 4; plane++) {
+						planes[plane * numWords + index] = (juce::uint8)(delta >> (8 * plane));
+					}
+				}
+			}
+
+			juce::MemoryOutputStream output{ compressed, false };
+			juce::GZIPCompressorOutputStream deflater{ output, 9 };
+			deflater.write(planes.get(), 4 * numWords);
+			deflater.flush();
+		}
+
+		// false if data doesn't inflate to exactly numChannels channels
+		bool decompressLevel(const void* data, size_t size, int numChannels, int numSamples, float* destination)
+		{
+			const auto numWords = (size_t)numChannels * (size_t)numSamples;
+			juce::HeapBlock<juce::uint8> planes(4 * numWords);
+			juce::MemoryInputStream input{ data, size, false };
+			juce::GZIPDecompressorInputStream inflater{ input };
+			if ((size_t)inflater.read(planes.get(), (int)(4 * numWords)) != 4 * numWords) {
+				return false;
+			}
+
+			for (int channel = 0; channel < numChannels; channel++) {
+				juce::uint32 previous = 0;
+				for (int i = 0; i < numSamples; i++) {
+					auto index = (size_t)channel * (size_t)numSamples + (size_t)i;
+					auto word = previous ^ ((juce::uint32)planes[index]
+						| (juce::uint32)planes[numWords + index] << 8
+						| (juce::uint32)planes[2 * numWords + index] << 16
+						| (juce::uint32)planes[3 * numWords + index] << 24);
+					previous = word;
+					std::memcpy(destination + index, &word, sizeof(word));
+				}
+			}
+			return true;
+		}
+	}
 
 	Wavetable::Wavetable(const juce::String& t_name, const juce::MemoryBlock& waveData) : name(t_name) {
+		jassert(isValidLegacyData(waveData));
 		auto channelsPerTable = int(waveData.getBitRange(0, 32));
 		auto wtResolution = int(waveData.getBitRange(32, 32));
 
-		//make sure we have exactly the data for 11 tables
-		jassert((waveData.getSize() - 8) == 11 * (wtResolution * channelsPerTable) * 4);
 		const float* dataPtr = reinterpret_cast<const float*>((waveData.begin() + 8));
 
 		for (int t = 0; t < 11; t++) {
@@ -27,30 +123,206 @@ namespace wavetable {
 		}
 	}
 
-	void Wavetable::toMemoryBlock(juce::MemoryBlock& blockToFill) const
+	Wavetable::Wavetable(const juce::String& t_name, std::unique_ptr<juce::MemoryMappedFile> t_mappedFile)
+		: name(t_name), mappedFile(std::move(t_mappedFile))
 	{
-		int numChannels = tables[0].getNumChannels() - 1;
-		int numSamples = tables[0].getNumSamples() - 1;
-		blockToFill.setSize(2 * 4 + 11 * numChannels * numSamples * 4);
+		jassert(mappedFile != nullptr && isValidFileData(mappedFile->getData(), mappedFile->getSize()));
+		auto* fileStart = static_cast<char*>(mappedFile->getData());
+		auto* header = reinterpret_cast<const FileHeader*>(fileStart);
+		const auto levelBytes = getLevelBytes(header->numChannels, header->numSamples);
+
+		// version 2 files hold the raw tables right behind the header
+		auto codec = FileCodec::RAW;
+		juce::uint64 levelOffsets[11];
+		for (int t = 0; t < 11; t++) {
+			levelOffsets[t] = sizeof(FileHeader) + (juce::uint64)t * levelBytes;
+		}
+		if (header->version == FILE_VERSION) {
+			auto* container = reinterpret_cast<const ContainerHeader*>(fileStart + sizeof(FileHeader));
+			auto* entries = reinterpret_cast<const LevelEntry*>(container + 1);
+			codec = container->codec;
+			for (int t = 0; t < 11; t++) {
+				levelOffsets[t] = entries[t].offset;
+			}
+			if (codec == FileCodec::COMPRESSED) {
+				storage.allocate(11 * levelBytes / sizeof(float), false);
+				for (int t = 0; t < 11; t++) {
+					auto* destination = storage.get() + t * levelBytes / sizeof(float);
+					if (!decompressLevel(fileStart + entries[t].offset, (size_t)entries[t].size,
+						header->numChannels, header->numSamples, destination)) {
+						// the crc matched, so only a broken writer gets here
+						jassertfalse;
+						juce::FloatVectorOperations::clear(destination, (int)(levelBytes / sizeof(float)));
+					}
+				}
+			}
+		}
+
+		juce::HeapBlock<float*> channelPtrs(header->numChannels);
+		for (int t = 0; t < 11; t++) {
+			// the mapping is read only, but the tables are only ever handed out as const
+			auto* dataPtr = codec == FileCodec::COMPRESSED ? storage.get() + t * levelBytes / sizeof(float)
+				: reinterpret_cast<float*>(fileStart + levelOffsets[t]);
+			for (int channel = 0; channel < header->numChannels; channel++) {
+				channelPtrs[channel] = dataPtr;
+				dataPtr += header->numSamples;
+			}
+			// refers to the mapped pages or the decoded storage, nothing else gets copied
+			tables[t] = juce::AudioBuffer<float>{ channelPtrs, header->numChannels, header->numSamples };
+		}
+
+		if (codec == FileCodec::COMPRESSED) {
+			// everything lives in storage now
+			mappedFile.reset();
+		}
+	}
+
+	Wavetable::~Wavetable()
+	{
+	}
+
+	void Wavetable::toMemoryBlock(juce::MemoryBlock& blockToFill, FileCodec codec) const
+	{
+		jassert(mipLevels == MipLevels::ALL);
+		int numChannels = tables[0].getNumChannels();
+		int numSamples = tables[0].getNumSamples();
+		const auto levelBytes = getLevelBytes(numChannels, numSamples);
+		const auto headerBytes = sizeof(FileHeader) + sizeof(ContainerHeader) + 11 * sizeof(LevelEntry);
+
+		// the last channel is never read, but generated tables leave it uninitialized
+		juce::AudioBuffer<float> level{ numChannels, numSamples };
+		level.clear(numChannels - 1, 0, numSamples);
+
+		LevelEntry entries[11]{};
 		{
-			int* dataPtr = static_cast<int*>(blockToFill.getData());
-			dataPtr[0] = numChannels;
-			dataPtr[1] = numSamples;
+			juce::MemoryOutputStream output{ blockToFill, false };
+			output.writeRepeatedByte(0, headerBytes);
+			for (int t = 0; t < 11; t++) {
+				auto& table = tables[t];
+				jassert(table.getNumChannels() == numChannels && table.getNumSamples() == numSamples);
+				for (int channel = 0; channel < numChannels - 1; channel++) {
+					level.copyFrom(channel, 0, table, channel, 0, numSamples);
+				}
+
+				output.writeRepeatedByte(0, alignUp((size_t)output.getPosition(), FILE_ALIGNMENT) - (size_t)output.getPosition());
+				entries[t].offset = (juce::uint64)output.getPosition();
+				if (codec == FileCodec::COMPRESSED) {
+					juce::MemoryBlock compressed;
+					compressLevel(level, compressed);
+					output.write(compressed.getData(), compressed.getSize());
+				}
+				else {
+					for (int channel = 0; channel < numChannels; channel++) {
+						output.write(level.getReadPointer(channel), (size_t)numSamples * sizeof(float));
+					}
+				}
+				entries[t].size = (juce::uint64)output.getPosition() - entries[t].offset;
+				entries[t].crc = crc32(static_cast<const char*>(output.getData()) + entries[t].offset, (size_t)entries[t].size);
+			}
+		}
+		jassert(codec == FileCodec::COMPRESSED || entries[10].size == levelBytes);
+		juce::ignoreUnused(levelBytes);
+
+		FileHeader header{ FILE_MAGIC, FILE_VERSION, numChannels, numSamples };
+		ContainerHeader container{ sampleRate, 11, codec, 0, 0 };
+		blockToFill.copyFrom(&header, 0, sizeof(FileHeader));
+		blockToFill.copyFrom(&container, sizeof(FileHeader), sizeof(ContainerHeader));
+		blockToFill.copyFrom(entries, sizeof(FileHeader) + sizeof(ContainerHeader), sizeof(entries));
+		container.headerCrc = crc32(blockToFill.getData(), headerBytes);
+		blockToFill.copyFrom(&container, sizeof(FileHeader), sizeof(ContainerHeader));
+	}
+
+	bool Wavetable::isValidFileData(const void* data, size_t size)
+	{
+		if (data == nullptr || size < sizeof(FileHeader)) {
+			return false;
+		}
+		auto* header = static_cast<const FileHeader*>(data);
+		if (header->magic != FILE_MAGIC || header->numChannels < 2 || header->numSamples < 2
+			|| header->numChannels > MAX_FILE_CHANNELS || header->numSamples > MAX_FILE_SAMPLES) {
+			return false;
+		}
+		const auto levelBytes = getLevelBytes(header->numChannels, header->numSamples);
+		if (header->version == MAPPED_LEGACY_VERSION) {
+			return size == sizeof(FileHeader) + 11 * levelBytes;
 		}
-		int memOffset = 8;
-		int bytesPerChannel = numSamples * 4;
+		if (header->version != FILE_VERSION) {
+			return false;
+		}
+
+		const auto headerBytes = sizeof(FileHeader) + sizeof(ContainerHeader) + 11 * sizeof(LevelEntry);
+		if (size < headerBytes) {
+			return false;
+		}
+		auto* bytes = static_cast<const char*>(data);
+		ContainerHeader container;
+		std::memcpy(&container, bytes + sizeof(FileHeader), sizeof(ContainerHeader));
+		if (container.numLevels != 11
+			|| (container.codec != FileCodec::RAW && container.codec != FileCodec::COMPRESSED)) {
+			return false;
+		}
+		// the crc is taken with its own field zeroed
+		auto storedCrc = container.headerCrc;
+		container.headerCrc = 0;
+		auto crc = crc32(bytes, sizeof(FileHeader));
+		crc = crc32(&container, sizeof(ContainerHeader), crc);
+		crc = crc32(bytes + sizeof(FileHeader) + sizeof(ContainerHeader), 11 * sizeof(LevelEntry), crc);
+		if (crc != storedCrc) {
+			return false;
+		}
+
+		auto* entries = reinterpret_cast<const LevelEntry*>(bytes + sizeof(FileHeader) + sizeof(ContainerHeader));
 		for (int t = 0; t < 11; t++) {
-			auto& table = tables[t];
-			for (int channel = 0; channel < numChannels; channel++) {
-				blockToFill.copyFrom(table.getReadPointer(channel), memOffset, bytesPerChannel);
-				memOffset += bytesPerChannel;
+			auto& entry = entries[t];
+			if (entry.offset < headerBytes || entry.offset > size || entry.size > size - entry.offset
+				|| entry.offset % alignof(float) != 0) {
+				return false;
+			}
+			if (container.codec == FileCodec::RAW ? entry.size != levelBytes : entry.size == 0) {
+				return false;
 			}
 		}
+		return container.codec == FileCodec::RAW || verifyLevelCrcs(data, size);
 	}
 
+	bool Wavetable::verifyLevelCrcs(const void* data, size_t size)
+	{
+		jassert(isValidFileData(data, size));
+		juce::ignoreUnused(size);
+		auto* bytes = static_cast<const char*>(data);
+		// version 2 files don't have any
+		if (static_cast<const FileHeader*>(data)->version != FILE_VERSION) {
+			return true;
+		}
+		auto* entries = reinterpret_cast<const LevelEntry*>(bytes + sizeof(FileHeader) + sizeof(ContainerHeader));
+		for (int t = 0; t < 11; t++) {
+			if (crc32(bytes + entries[t].offset, (size_t)entries[t].size) != entries[t].crc) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool Wavetable::isValidLegacyData(const juce::MemoryBlock& data)
+	{
+		if (data.getSize() < 8) {
+			return false;
+		}
+		auto channelsPerTable = int(data.getBitRange(0, 32));
+		auto wtResolution = int(data.getBitRange(32, 32));
+		if (channelsPerTable < 1 || wtResolution < 1
+			|| channelsPerTable > MAX_FILE_CHANNELS || wtResolution > MAX_FILE_SAMPLES) {
+			return false;
+		}
+		// exactly the data for 11 tables
+		return data.getSize() - 8 == 11 * getLevelBytes(channelsPerTable, wtResolution);
+	}
 
 	const juce::AudioBuffer<float>& Wavetable::getTable(int exponent) const
 	{
+		if (mipLevels == MipLevels::LOWEST_ONLY) {
+			return tables[0];
+		}
 		exponent = juce::jlimit(4, 14, exponent); // through pitch you could get values outside the normal frequency range
 		return tables[exponent - 4];
 	}
@@ -67,6 +339,35 @@ namespace wavetable {
 		return name;
 	}
 
+	bool Wavetable::isMadeFor(double t_sampleRate) const
+	{
+		return sampleRate == 0.0 || sampleRate == t_sampleRate;
+	}
+
+	bool Wavetable::hasMipLevels(MipLevels levels) const
+	{
+		return mipLevels == MipLevels::ALL || levels == MipLevels::LOWEST_ONLY;
+	}
+
+	size_t Wavetable::getSizeInBytes() const
+	{
+		std::set<const float*> channels;
+		size_t bytes = 0;
+		for (auto& table : tables) {
+			for (int channel = 0; channel < table.getNumChannels(); channel++) {
+				if (channels.insert(table.getReadPointer(channel)).second) {
+					bytes += (size_t)table.getNumSamples() * sizeof(float);
+				}
+			}
+		}
+		return bytes;
+	}
+
+	int Wavetable::getNumLevels() const
+	{
+		return mipLevels == MipLevels::ALL ? 11 : 1;
+	}
+
 	int Wavetable::getMaxHarmonics(double sampleRate)
 	{
 		jassert(sampleRate > 0);
@@ -75,88 +376,223 @@ namespace wavetable {
 
 	void Wavetable::createFromHarmonicWeights(double sampleRate, const juce::Array<double>& weights)
 	{
-		updateSineValues(sampleRate);
-		int maxHarmonics = getMaxHarmonics(sampleRate);
-		jassert(weights.size() == maxHarmonics);
+		jassert(weights.size() == getMaxHarmonics(sampleRate));
+		const int numLevels = getNumLevels();
+		const int numSamples = DEFAULT_WT_RESOLUTION + 1;
+
+		// the harmonic bound halves from one level to the next, so channel 2i of a level holds exactly the
+		// harmonics of channel i of the level below. only the lowest level gets all channels of its own,
+		// the ones above only their odd channels. the empty last channel is shared by all levels
+		const int numChannels = 1 + DEFAULT_NUM_CHANNELS + (numLevels - 1) * (DEFAULT_NUM_CHANNELS / 2);
+		storage.allocate((size_t)numChannels * numSamples, true);
+		auto* nextChannel = storage.get();
+		auto* emptyChannel = nextChannel;
+		nextChannel += numSamples;
+
+		std::vector<std::vector<float*>> channelPtrs((size_t)numLevels, std::vector<float*>(DEFAULT_NUM_CHANNELS + 1));
+		for (int level = 0; level < numLevels; level++) {
+			auto& levelPtrs = channelPtrs[(size_t)level];
+			for (int i = 0; i < DEFAULT_NUM_CHANNELS; i++) {
+				if (level > 0 && i % 2 == 0) {
+					levelPtrs[(size_t)i] = channelPtrs[(size_t)level - 1][(size_t)i / 2];
+				}
+				else {
+					levelPtrs[(size_t)i] = nextChannel;
+					nextChannel += numSamples;
+				}
+			}
+			levelPtrs[DEFAULT_NUM_CHANNELS] = emptyChannel;
+		}
+		jassert(nextChannel == storage.get() + (size_t)numChannels * numSamples);
 
-		juce::AudioBuffer<double> buffer{ maxHarmonics, DEFAULT_WT_RESOLUTION };
+		// the mip levels don't write to the same channels
+		GeneratorPool::getInstance()->run(numLevels, [this, sampleRate, &weights, &channelPtrs](int level) {
+			createMipLevel(level + 4, sampleRate, weights, channelPtrs[(size_t)level].data(), level == 0);
+			});
 
-		// fill buffer with weighted sine values
-		for (int i = 0; i < maxHarmonics; i++) {
-			buffer.copyFrom(i, 0, sineValues, i, 0, DEFAULT_WT_RESOLUTION);
-			buffer.applyGain(i, 0, DEFAULT_WT_RESOLUTION, weights[i]);
+		for (int level = 0; level < numLevels; level++) {
+			tables[level] = juce::AudioBuffer<float>{ channelPtrs[(size_t)level].data(), DEFAULT_NUM_CHANNELS + 1, numSamples };
 		}
+	}
+
+	GeneratorPool::GeneratorPool() : pool(juce::jmax(1, juce::SystemStats::getNumCpus() - 1))
+	{
+	}
+
+	void GeneratorPool::run(int numJobs, const std::function<void(int)>& job)
+	{
+		if (numJobs <= 0) {
+			return;
+		}
+		// workers may only get to their job after all jobs are done, so they share ownership of the round.
+		// they only touch job for indices they claimed, which are all finished before run returns
+		auto round = std::make_shared<Round>();
+		round->job = &job;
+		round->numJobs = numJobs;
+		for (int i = 1; i < numJobs; i++) {
+			pool.addJob([round] { claimJobs(*round); });
+		}
+		claimJobs(*round);
+		round->done.wait(-1);
+	}
+
+	void GeneratorPool::claimJobs(Round& round)
+	{
+		for (int index = round.nextJob.fetch_add(1); index < round.numJobs; index = round.nextJob.fetch_add(1)) {
+			(*round.job)(index);
+			if (round.finishedJobs.fetch_add(1) + 1 == round.numJobs) {
+				round.done.signal();
+			}
+		}
+	}
 
-		// calculate the sums in place 
-		// add in reverse order in hopes of less rounding errors 
-		// (Yes, the complexity is worse)
-		// also normalize the values to a [-1,1] range
-		for (int i = maxHarmonics - 1; i >= 0; i--) {
-			for (auto j = i - 1; j >= 0; j--) {
-				buffer.addFrom(i, 0, buffer, j, 0, DEFAULT_WT_RESOLUTION);
+	void Wavetable::createMipLevel(int exponent, double sampleRate, const juce::Array<double>& weights,
+		float* const* channels, bool withEvenChannels)
+	{
+		// number of harmonics for upper frequency bound
+		auto orderBound = static_cast<float>(sampleRate) / (2.f * std::powf(2.f, exponent + 1.f));
+		// a table can't hold harmonics above half its resolution
+		const int maxOrder = juce::jmin(weights.size(), DEFAULT_WT_RESOLUTION / 2) - 1;
+
+		juce::dsp::FFT fft{ FFT_ORDER };
+		std::vector<float> fftData(2 * DEFAULT_WT_RESOLUTION);
+
+		for (int i = withEvenChannels ? 0 : 1; i < DEFAULT_NUM_CHANNELS; i += withEvenChannels ? 1 : 2) {
+			auto* channel = channels[i];
+
+			// harmonics up to order0 get their full weight, the next one fades in with orderDelta
+			auto order = (i / (DEFAULT_NUM_CHANNELS - 1.f)) * orderBound;
+			auto order0 = juce::jmin(static_cast<int>(std::floorf(order)), maxOrder);
+			auto orderDelta = order0 < maxOrder ? order - order0 : 0.f;
+
+			// weights[h] belongs to harmonic h + 1, a sine is a negative imaginary part in its bin
+			std::fill(fftData.begin(), fftData.end(), 0.f);
+			for (int h = 0; h <= juce::jmin(order0 + 1, maxOrder); h++) {
+				auto gain = h <= order0 ? 1.f : orderDelta;
+				fftData[(size_t)(2 * (h + 1) + 1)] = -gain * static_cast<float>(weights[h]);
 			}
+			fft.performRealOnlyInverseTransform(fftData.data());
+
 			// normalize
-			buffer.applyGain(i, 0, DEFAULT_WT_RESOLUTION, 1.0 / buffer.getMagnitude(i, 0, DEFAULT_WT_RESOLUTION));
+			auto mag = juce::FloatVectorOperations::findMaximum(fftData.data(), DEFAULT_WT_RESOLUTION);
+			mag = juce::jmax(mag, -juce::FloatVectorOperations::findMinimum(fftData.data(), DEFAULT_WT_RESOLUTION));
+			juce::FloatVectorOperations::multiply(channel, fftData.data(), 1.f / mag, DEFAULT_WT_RESOLUTION);
+
+			// for wrap condition
+			channel[DEFAULT_WT_RESOLUTION] = channel[0];
 		}
+	}
 
-		for (int exponent = 4; exponent <= 14; exponent++) {
-			tables[exponent - 4] = juce::AudioBuffer<float>(DEFAULT_NUM_CHANNELS + 1, DEFAULT_WT_RESOLUTION + 1);
-			auto& wt = tables[exponent - 4];
-			// number of harmonics for upper frequency bound
-			auto orderBound = static_cast<float>(sampleRate) / (2.f * std::powf(2.f, exponent + 1.f));
+	WavetableHandoff::WavetableHandoff(MipLevels t_mipLevels) : loader(WavetableLoader::getInstance()), mipLevels(t_mipLevels)
+	{
+		loader->addHandoff(this);
+	}
 
-			for (int i = 0; i < DEFAULT_NUM_CHANNELS; i++) {
-				auto* channel = wt.getWritePointer(i);
+	WavetableHandoff::~WavetableHandoff()
+	{
+		// the loader might already be gone during shutdown
+		if (auto* currentLoader = WavetableLoader::getInstanceWithoutCreating()) {
+			currentLoader->removeHandoff(this);
+		}
+		if (auto* wt = pending.exchange(nullptr)) {
+			wt->decReferenceCount();
+		}
+	}
 
-				auto order = (i / (DEFAULT_NUM_CHANNELS - 1.f)) * orderBound;
-				auto order0 = static_cast<int>(std::floorf(order));
-				auto orderDelta = order - order0;
-				auto* srcChannel0 = buffer.getReadPointer(order0);
-				auto* srcChannel1 = buffer.getReadPointer(order0 + 1); // works since we have calculated some leftover harmonics
+	void WavetableHandoff::parameterChanged(configuration::ParamSuffix suffix, float newValue)
+	{
+		jassert(suffix == configuration::ParamSuffix::WT);
+		juce::ignoreUnused(suffix);
+		requestedIndex.store(static_cast<int>(newValue), std::memory_order_release);
+		loader->notify();
+	}
 
-				for (int sample = 0; sample < DEFAULT_WT_RESOLUTION; sample++) {
-					channel[sample] = (float)((1.f - orderDelta) * srcChannel0[sample] + orderDelta * srcChannel1[sample]);
-				}
+	void WavetableHandoff::setSampleRate(double newSampleRate)
+	{
+		sampleRate.store(newSampleRate);
+	}
 
-				// normalize
-				auto mag = wt.getMagnitude(i, 0, DEFAULT_WT_RESOLUTION);
-				for (int sample = 0; sample < DEFAULT_WT_RESOLUTION; sample++) {
-					channel[sample] /= mag;
-				}
-				
-				jassert(wt.getMagnitude(i, 0, DEFAULT_WT_RESOLUTION) == 1.f);
+	bool WavetableHandoff::hasPendingChange()
+	{
+		return pending.load(std::memory_order_acquire) != nullptr;
+	}
 
-				// for wrap condition
-				channel[DEFAULT_WT_RESOLUTION] = channel[0];
-			}
+	void WavetableHandoff::load()
+	{
+		auto index = requestedIndex.exchange(-1, std::memory_order_acq_rel);
+		if (index < 0) {
+			return;
+		}
+		auto wt = WavetableCache::getInstance()->getWavetable(index, sampleRate.load(), mipLevels);
+		if (wt == nullptr) {
+			return;
+		}
+		wt->incReferenceCount();
+		// a table which was never collected gets released here, on the loader thread
+		if (auto* replaced = pending.exchange(wt.get(), std::memory_order_acq_rel)) {
+			replaced->decReferenceCount();
+		}
+	}
 
-			// last channel can be left empty/uninitialized since it won't be accessed
+	void WavetableHandoff::collect(Wavetable::Ptr& current)
+	{
+		auto* next = pending.exchange(nullptr, std::memory_order_acquire);
+		if (next == nullptr) {
+			return;
 		}
+		// the cache still holds the old table, so this doesn't delete it
+		jassert(current == nullptr || current->getReferenceCount() > 1);
+		current = next;
+		next->decReferenceCountWithoutDeleting();
 	}
 
-	void Wavetable::updateSineValues(double sampleRate)
+	WavetableLoader::WavetableLoader() : juce::Thread("WavetableLoader")
 	{
-		jassert(sampleRate > 0.);
+		startThread();
+	}
 
-		// Nyquist
-		int maxHarmonics = getMaxHarmonics(sampleRate);
+	WavetableLoader::~WavetableLoader()
+	{
+		signalThreadShouldExit();
+		wakeUp.signal();
+		stopThread(10000);
+		clearSingletonInstance();
+	}
 
-		// check if already up to date
-		if (sineValues.getNumChannels() == maxHarmonics) {
-			return;
+	void WavetableLoader::addHandoff(WavetableHandoff* handoff)
+	{
+		const juce::ScopedLock sl(handoffLock);
+		handoffs.add(handoff);
+	}
+
+	void WavetableLoader::removeHandoff(WavetableHandoff* handoff)
+	{
+		// waits for a load of this handoff to finish
+		const juce::ScopedLock sl(handoffLock);
+		handoffs.removeFirstMatchingValue(handoff);
+	}
+
+	void WavetableLoader::notify()
+	{
+		wakeUp.signal();
+	}
+
+	void WavetableLoader::loadPending()
+	{
+		const juce::ScopedLock sl(handoffLock);
+		for (auto* handoff : handoffs) {
+			handoff->load();
 		}
+	}
 
-		sineValues = juce::AudioBuffer<double>(maxHarmonics, DEFAULT_WT_RESOLUTION);
-		for (int harmonic = 0; harmonic < maxHarmonics; harmonic++) {
-			auto* channel = sineValues.getWritePointer(harmonic);
-			for (int sample = 0; sample < DEFAULT_WT_RESOLUTION; sample++) {
-				channel[sample] = std::sin((harmonic + 1) * sample * juce::MathConstants<double>::twoPi / DEFAULT_WT_RESOLUTION);
-			}
-			// normalize
-			auto mag = sineValues.getMagnitude(harmonic, 0, DEFAULT_WT_RESOLUTION);
-			for (int sample = 0; sample < DEFAULT_WT_RESOLUTION; sample++) {
-				channel[sample] /= mag;
+	void WavetableLoader::run()
+	{
+		while (!threadShouldExit()) {
+			wakeUp.wait(-1);
+			if (threadShouldExit()) {
+				return;
 			}
+			loadPending();
 		}
 	}
 
@@ -189,54 +625,82 @@ namespace wavetable {
 		}
 	};
 
-	Wavetable::Ptr WavetableCache::getWavetable(const juce::String& wtName) {
-		// check if Wt is already in memory
-		for (auto& wt : wavetables) {
-			if (wt->getName().equalsIgnoreCase(wtName)) {
-				return wt;
+	Wavetable::Ptr WavetableCache::getWavetable(const juce::String& wtName, double sampleRate, MipLevels levels) {
+		jassert(sampleRate > 0.0);
+		const juce::ScopedLock sl(lock);
+		// check if Wt is already in memory, the most recently used one sits at the end
+		for (int i = wavetables.size() - 1; i >= 0; i--) {
+			auto* wt = wavetables.getObjectPointerUnchecked(i);
+			if (wt->getName().equalsIgnoreCase(wtName) && wt->isMadeFor(sampleRate) && wt->hasMipLevels(levels)) {
+				wavetables.move(i, -1);
+				hits++;
+				return wavetables.getLast();
 			}
 		}
+		misses++;
+
+		Wavetable::Ptr wt{ loadWavetable(wtName, sampleRate, levels) };
+		if (wt != nullptr) {
+			wavetables.add(wt);
+			bytesInCache += wt->getSizeInBytes();
+			evictOtherSampleRates(sampleRate);
+			evictUnused();
+		}
+		return wt;
+	}
 
-		if (wavetables.size() >= configuration::MAX_TABLES_IN_MEM) {
-			deleteUnused();
+	void WavetableCache::setMemoryBudget(size_t bytes)
+	{
+		const juce::ScopedLock sl(lock);
+		memoryBudget = bytes;
+		evictUnused();
+	}
+
+	WavetableCache::Stats WavetableCache::getStats()
+	{
+		const juce::ScopedLock sl(lock);
+		return { hits, misses, wavetables.size(), bytesInCache };
+	}
+
+	Wavetable* WavetableCache::loadWavetable(const juce::String& wtName, double sampleRate, MipLevels levels) {
+		// default wts are generated for the sample rate they're played at, which only takes a few milliseconds.
+		// files of them written by older versions are ignored, since they were always made for 44100.
+		// every plugin instance in every process shares a single copy of each generated table
+		int nameIndex = GENERATABLE_WT_NAMES.indexOf(wtName);
+		if (nameIndex != -1) {
+			return SharedWavetableStore::getOrGenerate(GENERATABLE_WT_NAMES[nameIndex], sampleRate, levels,
+				[this, nameIndex, sampleRate, levels] { return generateWavetable(nameIndex, sampleRate, levels); });
 		}
 
 		auto wtFile = wtFolder->getChildFile(wtName + configuration::WT_FILE_EXTENSION);
 		// try to load from a file
 		if (wtFile.existsAsFile()) {
-			if (wtFile.getSize() > 10 * 1000 * 1000) { // 10MB
-				jassertfalse;
+			// current files are used straight from the mapped pages, which the os shares between all processes
+			auto mappedFile = std::make_unique<juce::MemoryMappedFile>(wtFile, juce::MemoryMappedFile::readOnly);
+			if (Wavetable::isValidFileData(mappedFile->getData(), mappedFile->getSize())) {
+				return new Wavetable{ wtName, std::move(mappedFile) };
 			}
+			mappedFile.reset();
+
+			// legacy files get copied once and rewritten, so they can be mapped the next time
 			juce::MemoryBlock data;
-			if (!wtFile.loadFileAsData(data)) {
+			if (!wtFile.loadFileAsData(data) || !Wavetable::isValidLegacyData(data)) {
+				// damaged or truncated, never read past what's there
 				jassertfalse;
+				return nullptr;
 			}
 
 			Wavetable* wtPtr = new Wavetable{ wtName, data };
-			wavetables.add(wtPtr);
-			return wtPtr;
-		}
-		// see if it is a default wt which can be generated
-		int nameIndex = GENERATABLE_WT_NAMES.indexOf(wtName);
-		if (nameIndex != -1) {
-			// Note that we only generate wavetables with a sample rate of 44100
-			Wavetable* wtPtr;
-			switch (static_cast<GeneratableWt>(nameIndex)) {
-			case GeneratableWt::SawHarmonics:  wtPtr = new SawHarmonicsWavetable(GENERATABLE_WT_NAMES[nameIndex], 44100.0); break;
-			case GeneratableWt::TriangleHarmonics:  wtPtr = new TriangleHarmonicsWavetable(GENERATABLE_WT_NAMES[nameIndex], 44100.0); break;
-			case GeneratableWt::SquareHarmonics:  wtPtr = new SquareHarmonicsWavetable(GENERATABLE_WT_NAMES[nameIndex], 44100.0); break;
-			case GeneratableWt::PWM:  wtPtr = new PWMWavetable(GENERATABLE_WT_NAMES[nameIndex], 44100.0); break;
-			case GeneratableWt::Trapez:  wtPtr = new TrapezWavetable(GENERATABLE_WT_NAMES[nameIndex], 44100.0); break;
-			case GeneratableWt::WhiteNoise:  wtPtr = new WhiteNoiseWavetable(GENERATABLE_WT_NAMES[nameIndex], 44100.0); break;
-			default: jassertfalse; return nullptr; break;
-			}
-			// write the wavetable to the file so it can be easily loaded the next time it's needed
-			juce::MemoryBlock data;
-			wtPtr->toMemoryBlock(data);
-			if (!wtFile.replaceWithData(data.getData(), data.getSize())) {
-				jassertfalse;
+			data.reset();
+			// another instance might have rewritten and mapped it in the meantime, replacing a mapped file fails
+			// on windows. a failed rewrite only means the file gets copied again the next time
+			mappedFile = std::make_unique<juce::MemoryMappedFile>(wtFile, juce::MemoryMappedFile::readOnly);
+			auto isRewritten = Wavetable::isValidFileData(mappedFile->getData(), mappedFile->getSize());
+			mappedFile.reset();
+			if (!isRewritten) {
+				wtPtr->toMemoryBlock(data);
+				wtFile.replaceWithData(data.getData(), data.getSize());
 			}
-			wavetables.add(*wtPtr);
 			return wtPtr;
 		}
 
@@ -245,6 +709,18 @@ namespace wavetable {
 		return nullptr;
 	}
 
+	Wavetable* WavetableCache::generateWavetable(int nameIndex, double sampleRate, MipLevels levels) {
+		switch (static_cast<GeneratableWt>(nameIndex)) {
+		case GeneratableWt::SawHarmonics: return new SawHarmonicsWavetable(GENERATABLE_WT_NAMES[nameIndex], sampleRate, levels);
+		case GeneratableWt::TriangleHarmonics: return new TriangleHarmonicsWavetable(GENERATABLE_WT_NAMES[nameIndex], sampleRate, levels);
+		case GeneratableWt::SquareHarmonics: return new SquareHarmonicsWavetable(GENERATABLE_WT_NAMES[nameIndex], sampleRate, levels);
+		case GeneratableWt::PWM: return new PWMWavetable(GENERATABLE_WT_NAMES[nameIndex], sampleRate, levels);
+		case GeneratableWt::Trapez: return new TrapezWavetable(GENERATABLE_WT_NAMES[nameIndex], sampleRate, levels);
+		case GeneratableWt::WhiteNoise: return new WhiteNoiseWavetable(GENERATABLE_WT_NAMES[nameIndex], sampleRate, levels);
+		default: jassertfalse; return nullptr;
+		}
+	}
+
 	void WavetableCache::replaceIdWithName(juce::XmlElement& xml) {
 		jassert(xml.getTagName() == configuration::VALUE_TREE_IDENTIFIER);
 		for (auto* paramXml : xml.getChildIterator()) {
@@ -270,13 +746,34 @@ namespace wavetable {
 		}
 	}
 
-	void WavetableCache::deleteUnused() {
-		for (auto wtPtr : wavetables) {
-			if (wtPtr->getReferenceCount() == 1) {
-				wavetables.removeObject(wtPtr);
+	void WavetableCache::evictOtherSampleRates(double sampleRate) {
+		// after a sample rate change the tables for the old rate won't be asked for again
+		for (int i = 0; i < wavetables.size();) {
+			auto* wt = wavetables.getObjectPointerUnchecked(i);
+			if (!wt->isMadeFor(sampleRate) && wt->getReferenceCount() == 1) {
+				bytesInCache -= wt->getSizeInBytes();
+				wavetables.remove(i);
+			}
+			else {
+				i++;
 			}
 		}
-	};
+	}
+
+	void WavetableCache::evictUnused() {
+		// least recently used first. tables which are still referenced somewhere else are pinned,
+		// so the audio thread never ends up holding the last reference
+		for (int i = 0; i < wavetables.size() && bytesInCache > memoryBudget;) {
+			auto* wt = wavetables.getObjectPointerUnchecked(i);
+			if (wt->getReferenceCount() == 1) {
+				bytesInCache -= wt->getSizeInBytes();
+				wavetables.remove(i);
+			}
+			else {
+				i++;
+			}
+		}
+	}
 
 	void SawHarmonicsWavetable::create(double sampleRate)
 	{
@@ -317,11 +814,12 @@ namespace wavetable {
 
 	void PWMWavetable::create(double sampleRate)
 	{
-		updateSineValues(sampleRate);
-		auto saw = WavetableCache::getInstance()->getWavetable("SawHarmonics");
+		auto saw = WavetableCache::getInstance()->getWavetable("SawHarmonics", sampleRate, mipLevels);
 
-		for (int exponent = 4; exponent <= 14; exponent++) {
-			tables[exponent - 4] = juce::AudioBuffer<float>(DEFAULT_NUM_CHANNELS + 1, DEFAULT_WT_RESOLUTION + 1);
+		for (int exponent = 4; exponent < 4 + getNumLevels(); exponent++) {
+			// follow the resolution of the source, it might come from a file written by an older version
+			const int resolution = saw->getTable(exponent).getNumSamples() - 1;
+			tables[exponent - 4] = juce::AudioBuffer<float>(DEFAULT_NUM_CHANNELS + 1, resolution + 1);
 			auto& wt = tables[exponent - 4];
 
 			// the second to last channel (62) has a saw wave with all available harmonics
@@ -332,16 +830,16 @@ namespace wavetable {
 				// we dont want the case wtPosition = 0 since this would result in a constant wavefunction
 				float wtPosition = (i + delta) / (DEFAULT_NUM_CHANNELS-1.f + delta);
 
-				for (int sample = 0; sample < DEFAULT_WT_RESOLUTION; sample++) {
+				for (int sample = 0; sample < resolution; sample++) {
 					channel[sample] = sawChannel[sample]
-						- sawChannel[(sample + (int)(wtPosition * DEFAULT_WT_RESOLUTION / 2.f)) % DEFAULT_WT_RESOLUTION]
+						- sawChannel[(sample + (int)(wtPosition * resolution / 2.f)) % resolution]
 						+ (wtPosition - 1);
 				}
 				// for wrap condition
-				channel[DEFAULT_WT_RESOLUTION] = channel[0];
+				channel[resolution] = channel[0];
 
 				// normalize
-				wt.applyGain(i, 0, DEFAULT_WT_RESOLUTION + 1, 1.0f / wt.getMagnitude(i, 0, DEFAULT_WT_RESOLUTION + 1));
+				wt.applyGain(i, 0, resolution + 1, 1.0f / wt.getMagnitude(i, 0, resolution + 1));
 			}
 
 			// last channel can be left empty/uninitialized since it won't be accessed
@@ -350,11 +848,12 @@ namespace wavetable {
 
 	void TrapezWavetable::create(double sampleRate)
 	{
-		updateSineValues(sampleRate);
-		auto triangle = WavetableCache::getInstance()->getWavetable("TriangleHarmonics");
+		auto triangle = WavetableCache::getInstance()->getWavetable("TriangleHarmonics", sampleRate, mipLevels);
 
-		for (int exponent = 4; exponent <= 14; exponent++) {
-			tables[exponent - 4] = juce::AudioBuffer<float>(DEFAULT_NUM_CHANNELS + 1, DEFAULT_WT_RESOLUTION + 1);
+		for (int exponent = 4; exponent < 4 + getNumLevels(); exponent++) {
+			// follow the resolution of the source, it might come from a file written by an older version
+			const int resolution = triangle->getTable(exponent).getNumSamples() - 1;
+			tables[exponent - 4] = juce::AudioBuffer<float>(DEFAULT_NUM_CHANNELS + 1, resolution + 1);
 			auto& wt = tables[exponent - 4];
 
 			// the second to last channel (62) has a triangle wave with all available harmonics
@@ -365,17 +864,17 @@ namespace wavetable {
 				// we dont want the case wtPosition = 1 since we divide by (wtPosition - 1)
 				float wtPosition = (i) / (DEFAULT_NUM_CHANNELS - 1.f + delta);
 
-				for (int sample = 0; sample < DEFAULT_WT_RESOLUTION; sample++) {
+				for (int sample = 0; sample < resolution; sample++) {
 					jassert(1.f - wtPosition != 0.f);
 					channel[sample] = (triangleChannel[sample]
-						+ triangleChannel[(sample + (int)(wtPosition * DEFAULT_WT_RESOLUTION / 2.f)) % DEFAULT_WT_RESOLUTION])
+						+ triangleChannel[(sample + (int)(wtPosition * resolution / 2.f)) % resolution])
 						/ (2.f * (1.f - wtPosition));
 				}
 				// for wrap condition
-				channel[DEFAULT_WT_RESOLUTION] = channel[0];
+				channel[resolution] = channel[0];
 
 				// normalize
-				wt.applyGain(i, 0, DEFAULT_WT_RESOLUTION + 1, 1.0f / wt.getMagnitude(i, 0, DEFAULT_WT_RESOLUTION + 1));
+				wt.applyGain(i, 0, resolution + 1, 1.0f / wt.getMagnitude(i, 0, resolution + 1));
 			}
 
 			// last channel can be left empty/uninitialized since it won't be accessed
@@ -386,24 +885,81 @@ namespace wavetable {
 	{
 		juce::ignoreUnused(sampleRate);
 		juce::Random random{};
-		for (int exponent = 4; exponent <= 14; exponent++) {
-			tables[exponent - 4] = juce::AudioBuffer<float>(5 + 1, DEFAULT_WT_RESOLUTION + 1);
-			auto& wt = tables[exponent - 4];
+		tables[0] = juce::AudioBuffer<float>(5 + 1, DEFAULT_WT_RESOLUTION + 1);
+		auto& wt = tables[0];
 
-			for (int i = 0; i < 5; i++) {
-				auto* channel = wt.getWritePointer(i);
+		for (int i = 0; i < 5; i++) {
+			auto* channel = wt.getWritePointer(i);
 
-				for (int sample = 0; sample < DEFAULT_WT_RESOLUTION; sample++) {
-					channel[sample] = (random.nextFloat() * 2.f) - 1.f;
-				}
+			for (int sample = 0; sample < DEFAULT_WT_RESOLUTION; sample++) {
+				channel[sample] = (random.nextFloat() * 2.f) - 1.f;
+			}
+			// for wrap condition
+			channel[DEFAULT_WT_RESOLUTION] = channel[0];
+
+			// normalize
+			wt.applyGain(i, 0, DEFAULT_WT_RESOLUTION + 1, 1.0f / wt.getMagnitude(i, 0, DEFAULT_WT_RESOLUTION + 1));
+		}
+
+		// last channel can be left empty/uninitialized since it won't be accessed
+
+		// noise isn't band limited anyway, so the other levels just refer to the same channels
+		for (int level = 1; level < getNumLevels(); level++) {
+			tables[level] = juce::AudioBuffer<float>{ wt.getArrayOfWritePointers(), wt.getNumChannels(), wt.getNumSamples() };
+		}
+	}
+
+	FrameWavetable::FrameWavetable(const juce::String& t_name, const juce::AudioBuffer<float>& frames, double sampleRate)
+		: Wavetable(t_name, sampleRate, MipLevels::ALL)
+	{
+		const int numFrames = frames.getNumChannels();
+		const int frameSize = frames.getNumSamples();
+		jassert(numFrames > 0 && frameSize >= 4 && juce::isPowerOfTwo(frameSize));
+		// harmonics both the frames and the tables can hold
+		const int maxOrder = juce::jmin(frameSize, DEFAULT_WT_RESOLUTION) / 2 - 1;
+
+		// the spectrum of every frame, with real and imaginary part of each bin next to each other
+		juce::dsp::FFT frameFft{ static_cast<int>(std::log2(frameSize)) };
+		std::vector<std::vector<float>> spectra;
+		for (int frame = 0; frame < numFrames; frame++) {
+			std::vector<float> spectrum(2 * (size_t)frameSize);
+			std::copy(frames.getReadPointer(frame), frames.getReadPointer(frame) + frameSize, spectrum.begin());
+			frameFft.performRealOnlyForwardTransform(spectrum.data(), true);
+			spectra.push_back(std::move(spectrum));
+		}
+
+		juce::dsp::FFT fft{ FFT_ORDER };
+		std::vector<float> fftData(2 * DEFAULT_WT_RESOLUTION);
+		float peak = 0.f;
+
+		for (int exponent = 4; exponent <= 14; exponent++) {
+			tables[exponent - 4] = juce::AudioBuffer<float>(numFrames + 1, DEFAULT_WT_RESOLUTION + 1);
+			auto& wt = tables[exponent - 4];
+			// harmonics above this would alias at the upper frequency bound, the fundamental is always kept
+			auto order = juce::jlimit(1, maxOrder, static_cast<int>(sampleRate / (2. * std::exp2(exponent + 1.))));
+
+			for (int frame = 0; frame < numFrames; frame++) {
+				auto& spectrum = spectra[(size_t)frame];
+				// dc is dropped as well
+				std::fill(fftData.begin(), fftData.end(), 0.f);
+				std::copy(spectrum.begin() + 2, spectrum.begin() + 2 * (order + 1), fftData.begin() + 2);
+				fft.performRealOnlyInverseTransform(fftData.data());
+
+				auto* channel = wt.getWritePointer(frame);
+				std::copy(fftData.begin(), fftData.begin() + DEFAULT_WT_RESOLUTION, channel);
 				// for wrap condition
 				channel[DEFAULT_WT_RESOLUTION] = channel[0];
-
-				// normalize
-				wt.applyGain(i, 0, DEFAULT_WT_RESOLUTION + 1, 1.0f / wt.getMagnitude(i, 0, DEFAULT_WT_RESOLUTION + 1));
+				peak = juce::jmax(peak, wt.getMagnitude(frame, 0, DEFAULT_WT_RESOLUTION));
 			}
+			// clear last channel
+			wt.clear(numFrames, 0, wt.getNumSamples());
+		}
 
-			// last channel can be left empty/uninitialized since it won't be accessed
+		// a single gain for all tables keeps the frames and levels as loud as they are relative to each other
+		if (peak > 0.f) {
+			for (auto& table : tables) {
+				table.applyGain(1.f / peak);
+			}
 		}
 	}
-}
\ No newline at end of file
+}
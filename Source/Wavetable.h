@@ -3,41 +3,138 @@
 
 #include <JuceHeader.h>
 #include "Configuration.h"
+#include "ParameterSnapshot.h"
 
 namespace wavetable {
 
-	// Wavetables as data:
-	// 4 Byte (int) for number of channels per table
-	// 4 Byte (int) for wtResolution
-	// then just the 11 wavetables one after another starting with low frequency tables 
-	// and ending with the highest, going from first to last channel
-	// empty channels and redundant values at the end, which we use at runtime, won't be safed to disk and will be appended, when reading from disk
+	// Wavetables as data (version 3):
+	// a FileHeader, a ContainerHeader and a LevelEntry for each of the 11 wavetables, starting with low frequency
+	// tables and ending with the highest. every entry holds offset, size and crc of its table in the file.
+	// the headers are covered by a crc of their own, so a damaged or truncated file is rejected before it's used.
+	// raw tables are stored exactly like they're used at runtime, going from first to last channel and including
+	// the empty last channel and the repeated first sample at the end of each channel,
+	// so a raw file can be used straight from mapped memory.
+	// compressed tables are decoded when loading, see FileCodec.
+	//
+	// Version 2 files have just the FileHeader, followed by the raw tables one after another. they're still mapped.
+	//
+	// Legacy files (version 1) start with 4 Byte (int) for number of channels per table and 4 Byte (int) for
+	// wtResolution, followed by the tables without the empty channel and the repeated sample.
+	// these get copied when loading and are rewritten as raw version 3
+
+	// the mip levels a user of a wavetable reads. lfos only ever read the lowest one,
+	// so generated tables for them leave out the other ten
+	enum class MipLevels {
+		ALL,
+		LOWEST_ONLY,
+	};
+
+	class SharedMemory;
 
 	class Wavetable : public juce::ReferenceCountedObject {
 	public:
 		using Ptr = juce::ReferenceCountedObjectPtr<Wavetable>;
 		Wavetable() = delete;
-		Wavetable(const juce::String& t_name, const juce::MemoryBlock& waveData);
-		virtual ~Wavetable() override {}
+		// how the tables are stored in a file
+		enum class FileCodec : juce::uint32 {
+			// exactly like at runtime, can be mapped
+			RAW,
+			// lossless: every sample is xored with the one before it, the results are split into byte planes
+			// and deflated. smooth waveforms leave mostly zeros in the upper planes, which deflate very well
+			COMPRESSED,
+		};
 
-		void toMemoryBlock(juce::MemoryBlock& blockToFill) const;
+		// copies the tables from a legacy file, which has to pass isValidLegacyData
+		Wavetable(const juce::String& t_name, const juce::MemoryBlock& waveData);
+		// uses the tables right where they are in the mapped file, which has to pass isValidFileData.
+		// compressed tables are decoded and the file is unmapped again
+		Wavetable(const juce::String& t_name, std::unique_ptr<juce::MemoryMappedFile> t_mappedFile);
+		virtual ~Wavetable() override;
+
+		// writes the current (version 3) layout, only for tables with all mip levels
+		void toMemoryBlock(juce::MemoryBlock& blockToFill, FileCodec codec = FileCodec::RAW) const;
+
+		// checks whether data holds a complete wavetable in the current or the version 2 layout. the crcs of
+		// compressed levels are checked since they're decoded anyway, raw levels are left untouched so their
+		// pages aren't read before they're used. verifyLevelCrcs checks those
+		static bool isValidFileData(const void* data, size_t size);
+		// checks the crcs of all levels of data, which has to pass isValidFileData. reads the whole file
+		static bool verifyLevelCrcs(const void* data, size_t size);
+		// checks whether data holds exactly the tables its legacy (version 1) header announces
+		static bool isValidLegacyData(const juce::MemoryBlock& data);
 
 		const juce::AudioBuffer<float>& getTable(int exponent) const;
 		const juce::AudioBuffer<float>& getTable(float frequency) const;
 
 		const juce::String& getName();
 
+		// whether the tables are band limited for sampleRate. tables from files aren't made for any rate in particular
+		bool isMadeFor(double sampleRate) const;
+		// whether a user reading levels can use this table
+		bool hasMipLevels(MipLevels levels) const;
+
+		// memory taken by the tables, mapped or not. channels shared by several tables count once
+		size_t getSizeInBytes() const;
+
 	protected:
-		Wavetable(const juce::String& t_name) : name(t_name) {}
+		Wavetable(const juce::String& t_name, double t_sampleRate, MipLevels t_mipLevels)
+			: name(t_name), sampleRate(t_sampleRate), mipLevels(t_mipLevels) {}
+
+		// number of tables which actually hold data
+		int getNumLevels() const;
 
 		static int getMaxHarmonics(double sampleRate);
+		// builds every channel of every mip level from its spectrum with an inverse fft
 		void createFromHarmonicWeights(double sampleRate, const juce::Array<double>& weights);
-
-		// idempotent with same sampleRate
-		static void updateSineValues(double sampleRate);
-		inline static juce::AudioBuffer<double> sineValues;
+		// fills the odd channels of a mip level, the even ones too if withEvenChannels is set
+		void createMipLevel(int exponent, double sampleRate, const juce::Array<double>& weights,
+			float* const* channels, bool withEvenChannels);
+
+		struct FileHeader {
+			juce::uint32 magic;
+			juce::uint32 version;
+			// both include the empty channel and the repeated sample
+			juce::int32 numChannels;
+			juce::int32 numSamples;
+		};
+		// follows the FileHeader in version 3
+		struct ContainerHeader {
+			// the rate the tables are band limited for, 0 if they aren't made for a particular one
+			double sampleRate;
+			juce::uint32 numLevels;
+			FileCodec codec;
+			// of all headers and level entries, with this field set to 0
+			juce::uint32 headerCrc;
+			juce::uint32 reserved;
+		};
+		struct LevelEntry {
+			// from the start of the file
+			juce::uint64 offset;
+			juce::uint64 size;
+			juce::uint32 crc;
+			juce::uint32 reserved;
+		};
+		static constexpr juce::uint32 FILE_MAGIC = 0x54575953; // "SYWT"
+		static constexpr juce::uint32 FILE_VERSION = 3;
+		static constexpr juce::uint32 MAPPED_LEGACY_VERSION = 2;
+		// tables start at multiples of this, so raw tables are aligned when mapped
+		static constexpr size_t FILE_ALIGNMENT = 64;
+		// anything larger is treated as a broken file
+		static constexpr int MAX_FILE_CHANNELS = 4096;
+		static constexpr int MAX_FILE_SAMPLES = 1 << 16;
 
 		juce::String name;
+		// the rate the tables were generated for, 0 for tables from files
+		double sampleRate = 0.0;
+		// tables from files always have all levels, they're mapped and unused levels never get paged in
+		MipLevels mipLevels = MipLevels::ALL;
+
+		// keeps the pages the tables point to mapped, nullptr if the tables own their data
+		std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+		// holds the channels of tables which share channels between their levels
+		juce::HeapBlock<float> storage;
+		// keeps the tables mapped which live in shared memory, see SharedWavetableStore
+		std::unique_ptr<SharedMemory> sharedMemory;
 
 		// tables[i] holds the wavetable for frequencies f with 2^(i+4) < f <= 2^(i+5)
 		// (for lower frequencies we have more and higher harmonics)
@@ -45,17 +142,126 @@ namespace wavetable {
 		// last sample == first sample to simplify calculations
 		// each wavetable can have a different number of channels, but the last one will not be used; again to simplify calculations
 		// I will go with 63+1 channels
+		// with MipLevels::LOWEST_ONLY only tables[0] holds data and is returned for every frequency
 		juce::AudioBuffer<float> tables[11];
 		static const int DEFAULT_NUM_CHANNELS = 63;
 		// number of samples for one cycle
-		static const int DEFAULT_WT_RESOLUTION = 2048 - 1;
+		static const int DEFAULT_WT_RESOLUTION = 2048;
+		// generated tables come straight out of an inverse fft, so the resolution has to be a power of two
+		static const int FFT_ORDER = 11;
+		static_assert((1 << FFT_ORDER) == DEFAULT_WT_RESOLUTION);
+		// the last used channel has to be even to be shared with the level below
+		static_assert(DEFAULT_NUM_CHANNELS % 2 == 1);
 
 	private:
+		friend class SharedWavetableStore;
 
 		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Wavetable)
 	};
 
 
+	// Worker threads which generate the mip levels of a table in parallel. All generations share them, so nested
+	// and concurrent generations don't start threads of their own.
+	class GeneratorPool : private juce::DeletedAtShutdown {
+	public:
+		GeneratorPool();
+		~GeneratorPool() override { clearSingletonInstance(); }
+
+		JUCE_DECLARE_SINGLETON(GeneratorPool, false);
+
+		// runs job(i) for all i in [0, numJobs) and returns once all of them are done. the calling thread
+		// works on the jobs as well, so it never waits for a job no thread has started
+		void run(int numJobs, const std::function<void(int)>& job);
+
+	private:
+		struct Round {
+			const std::function<void(int)>* job;
+			int numJobs;
+			std::atomic<int> nextJob{ 0 };
+			std::atomic<int> finishedJobs{ 0 };
+			juce::WaitableEvent done;
+		};
+
+		static void claimJobs(Round& round);
+
+		juce::ThreadPool pool;
+
+		JUCE_DECLARE_NON_COPYABLE(GeneratorPool)
+	};
+
+
+	class WavetableLoader;
+
+	// Hands a wavetable to the audio thread. Changing a wavetable parameter only files a request, which is
+	// safe on any thread, including the audio thread during automation. The WavetableLoader thread loads the
+	// table and publishes it, until then the old table keeps playing. The audio thread only swaps pointers and
+	// since the cache keeps every table it hands out until nobody else uses it, it never deletes a wavetable.
+	class WavetableHandoff : public customDsp::ParameterSnapshot::Listener {
+	public:
+		WavetableHandoff(MipLevels t_mipLevels = MipLevels::ALL);
+		virtual ~WavetableHandoff() override;
+
+		// tables get loaded for this rate from now on
+		void setSampleRate(double newSampleRate);
+
+		// requests the wavetable with the index newValue. only the latest request of a handoff gets loaded
+		virtual void parameterChanged(configuration::ParamSuffix suffix, float newValue) override;
+
+		// true if a loaded wavetable is waiting to be collected
+		virtual bool hasPendingChange() override;
+
+		// replaces current with the latest published wavetable, if there is one
+		void collect(Wavetable::Ptr& current);
+
+	private:
+		friend class WavetableLoader;
+
+		// loads the requested wavetable and publishes it, only called by the loader
+		void load();
+
+		WavetableLoader* loader;
+		const MipLevels mipLevels;
+		std::atomic<int> requestedIndex{ -1 };
+		std::atomic<double> sampleRate{ 44100.0 };
+		// holds one reference while published
+		std::atomic<Wavetable*> pending{ nullptr };
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WavetableHandoff)
+	};
+
+
+	// Background thread which does all the loading and generating of wavetables requested through handoffs.
+	class WavetableLoader : private juce::Thread, private juce::DeletedAtShutdown {
+	public:
+		WavetableLoader();
+		~WavetableLoader() override;
+
+		JUCE_DECLARE_SINGLETON(WavetableLoader, true);
+
+		void addHandoff(WavetableHandoff* handoff);
+		void removeHandoff(WavetableHandoff* handoff);
+
+		// wakes up the loader thread, doesn't allocate or touch any files
+		void notify();
+
+		// loads all outstanding requests on the calling thread. used where waiting is fine and a table has
+		// to be there right away, e.g. in prepareToPlay. must not be called from the audio thread
+		void loadPending();
+
+	private:
+		virtual void run() override;
+
+		juce::CriticalSection handoffLock;
+		juce::Array<WavetableHandoff*> handoffs;
+		juce::WaitableEvent wakeUp;
+
+		JUCE_DECLARE_NON_COPYABLE(WavetableLoader)
+	};
+
+
+	// Keeps recently used wavetables around within a memory budget. Tables are evicted least recently used
+	// first, but never while they're referenced anywhere else. Eviction only happens in getWavetable and
+	// setMemoryBudget, which are never called from the audio thread.
 	class WavetableCache : private juce::DeletedAtShutdown {
 	public:
 		WavetableCache();
@@ -63,27 +269,65 @@ namespace wavetable {
 
 		JUCE_DECLARE_SINGLETON(WavetableCache, true);
 
-		Wavetable::Ptr getWavetable(int nameIndex) {
-			return getWavetable(wavetableNames[nameIndex]);
+		// bump whenever the output of a generator changes. factory tables and shared tables of
+		// other versions are ignored then
+		static constexpr int GENERATOR_VERSION = 1;
+
+		// generated tables are cached per sample rate, tables from files are shared by all rates.
+		// a request for the lowest level only may get a table with all levels if there already is one
+		Wavetable::Ptr getWavetable(int nameIndex, double sampleRate, MipLevels levels = MipLevels::ALL) {
+			return getWavetable(wavetableNames[nameIndex], sampleRate, levels);
 		}
 
-		Wavetable::Ptr getWavetable(const juce::String& wtName);
+		Wavetable::Ptr getWavetable(const juce::String& wtName, double sampleRate, MipLevels levels = MipLevels::ALL);
+
+		// evicts unused tables right away if the cache is already over the new budget
+		void setMemoryBudget(size_t bytes);
+
+		struct Stats {
+			int hits;
+			int misses;
+			int numTables;
+			size_t bytesInCache;
+		};
+		Stats getStats();
 
 		const juce::StringArray& getWavetableNames() {
 			return wavetableNames;
 		}
 
+		// the tables which are generated instead of loaded from files
+		const juce::StringArray& getGeneratableWavetableNames() const {
+			return GENERATABLE_WT_NAMES;
+		}
+
 		void replaceIdWithName(juce::XmlElement& xml);
 
 		void replaceNameWithId(juce::XmlElement& xml);
 
+		// runs the generator of a generatable table, bypassing the cache, the shared store and the factory tables
+		Wavetable* generateWavetable(int nameIndex, double sampleRate, MipLevels levels);
+
 	private:
 
-		void deleteUnused();
+		// loads or generates the table, without adding it to the cache
+		Wavetable* loadWavetable(const juce::String& wtName, double sampleRate, MipLevels levels);
+
+		void evictOtherSampleRates(double sampleRate);
+		void evictUnused();
+
+		// the loader thread and the message thread may ask for wavetables at the same time
+		juce::CriticalSection lock;
+
+		size_t memoryBudget = configuration::WT_CACHE_BUDGET_BYTES;
+		size_t bytesInCache = 0;
+		int hits = 0;
+		int misses = 0;
 
 		std::unique_ptr<juce::File> wtFolder;
 		juce::StringArray wavetableNames;
 
+		// ordered from least to most recently used
 		juce::ReferenceCountedArray<Wavetable, juce::CriticalSection> wavetables;
 
 		enum class GeneratableWt {
@@ -109,7 +353,8 @@ namespace wavetable {
 
 	class SawHarmonicsWavetable : public Wavetable {
 	public:
-		SawHarmonicsWavetable(const juce::String& t_name, double sampleRate) : Wavetable(t_name) {
+		SawHarmonicsWavetable(const juce::String& t_name, double sampleRate, MipLevels levels)
+			: Wavetable(t_name, sampleRate, levels) {
 			create(sampleRate);
 		}
 		virtual ~SawHarmonicsWavetable() override {};
@@ -122,7 +367,8 @@ namespace wavetable {
 
 	class SquareHarmonicsWavetable : public Wavetable {
 	public:
-		SquareHarmonicsWavetable(const juce::String& t_name, double sampleRate) : Wavetable(t_name) {
+		SquareHarmonicsWavetable(const juce::String& t_name, double sampleRate, MipLevels levels)
+			: Wavetable(t_name, sampleRate, levels) {
 			create(sampleRate);
 		}
 		virtual ~SquareHarmonicsWavetable() override {};
@@ -135,7 +381,8 @@ namespace wavetable {
 
 	class TriangleHarmonicsWavetable : public Wavetable {
 	public:
-		TriangleHarmonicsWavetable(const juce::String& t_name, double sampleRate) : Wavetable(t_name) {
+		TriangleHarmonicsWavetable(const juce::String& t_name, double sampleRate, MipLevels levels)
+			: Wavetable(t_name, sampleRate, levels) {
 			create(sampleRate);
 		}
 		virtual ~TriangleHarmonicsWavetable() override {};
@@ -149,7 +396,8 @@ namespace wavetable {
 	// for a period of P with wtPosition t: pwm(x) = saw(x) - saw(x+t*P/2) + (t-1)
 	class PWMWavetable : public Wavetable {
 	public:
-		PWMWavetable(const juce::String& t_name, double sampleRate) : Wavetable(t_name) {
+		PWMWavetable(const juce::String& t_name, double sampleRate, MipLevels levels)
+			: Wavetable(t_name, sampleRate, levels) {
 			create(sampleRate);
 		}
 		virtual ~PWMWavetable() override {};
@@ -163,7 +411,8 @@ namespace wavetable {
 	// for a period of P with wtPosition t: trapez(x) = (triangle(x) + triangle(x+t*P/2))/(2*(t-1))
 	class TrapezWavetable : public Wavetable {
 	public:
-		TrapezWavetable(const juce::String& t_name, double sampleRate) : Wavetable(t_name) {
+		TrapezWavetable(const juce::String& t_name, double sampleRate, MipLevels levels)
+			: Wavetable(t_name, sampleRate, levels) {
 			create(sampleRate);
 		}
 		virtual ~TrapezWavetable() override {};
@@ -174,9 +423,23 @@ namespace wavetable {
 		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TrapezWavetable)
 	};
 
+	// Built from single cycle frames, e.g. the frames of a wav file. Every frame becomes one channel and is band
+	// limited for each mip level by dropping all harmonics which would alias at sampleRate.
+	// the levels are made one after another, so converting many files at once can use all cores
+	class FrameWavetable : public Wavetable {
+	public:
+		// every channel of frames holds one cycle, the number of samples has to be a power of two
+		FrameWavetable(const juce::String& t_name, const juce::AudioBuffer<float>& frames, double sampleRate);
+		virtual ~FrameWavetable() override {};
+
+	private:
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FrameWavetable)
+	};
+
 	class WhiteNoiseWavetable : public Wavetable {
 	public:
-		WhiteNoiseWavetable(const juce::String& t_name, double sampleRate) : Wavetable(t_name) {
+		WhiteNoiseWavetable(const juce::String& t_name, double sampleRate, MipLevels levels)
+			: Wavetable(t_name, sampleRate, levels) {
 			create(sampleRate);
 		}
 		virtual ~WhiteNoiseWavetable() override {};
@@ -0,0 +1,356 @@
+/*
+  ==============================================================================
+
+	Times every processor on its own, created through its SharedData like the plugin does,
+	and prints ns/sample for a grid of block sizes, sample rates and modulation on/off.
+	InterpolationOscBatch<n> cases time InterpolationOsc::processBatch with n voices and report ns/sample per voice.
+
+	usage: Benchmark [--json] [--out <file>] [--seconds <audio seconds per measurement>]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/DSP.h"
+#include "../../../Source/Filter.h"
+#include "../../../Source/FX.h"
+#include "../../../Source/Modulation.h"
+
+namespace {
+
+	const int BLOCK_SIZES[]{ 32, 64, 128, 256, 512, 1024, 2048 };
+	const double SAMPLE_RATES[]{ 44100.0, 48000.0, 88200.0, 96000.0, 192000.0 };
+
+	// mod channels used when modulation is on
+	const int ENV_CHANNEL = 0;
+	const int LFO_CHANNEL = configuration::ENV_NUMBER;
+
+	struct BenchmarkCase {
+		juce::String name;
+		// output channels the processor works on inside a voice
+		int numChannels;
+		std::function<std::unique_ptr<customDsp::Processor::SharedData>()> createData;
+		// routes all modulation targets of data to the env and lfo channels, nullptr if there are none
+		std::function<void(customDsp::Processor::SharedData& data)> addModulation;
+		// 0 times process, otherwise processBatch with this many voices of an InterpolationOsc
+		int batchVoices = 0;
+	};
+
+	struct Result {
+		juce::String name;
+		int blockSize;
+		double sampleRate;
+		bool modulated;
+		double nsPerSample;
+	};
+
+	void routeModulation(customDsp::ModulationParam* modParams, int numParams, int firstChannel)
+	{
+		for (int i = 0; i < numParams; i++) {
+			modParams[i].src_channel = i == 0 ? firstChannel : LFO_CHANNEL;
+			modParams[i].factor = 0.5f;
+		}
+	}
+
+	template <typename DataType>
+	std::unique_ptr<customDsp::Processor::SharedData> makeData(std::function<void(DataType&)> setup = {})
+	{
+		auto data = std::make_unique<DataType>("BENCHMARK");
+		if (setup) {
+			setup(*data);
+		}
+		return data;
+	}
+
+	std::unique_ptr<customDsp::Processor::SharedData> makeFxData(customDsp::FXType type)
+	{
+		return makeData<customDsp::FXChooser::SharedData>([type](auto& data) {
+			data.fxType = type;
+			data.dryWet = 0.5f;
+			data.parameter0 = 0.5f;
+			data.parameter1 = 0.5f;
+			data.parameter2 = 0.5f;
+			});
+	}
+
+	std::function<void(customDsp::Processor::SharedData&)> fxModulation()
+	{
+		return [](customDsp::Processor::SharedData& data) {
+			auto& fxData = static_cast<customDsp::FXChooser::SharedData&>(data);
+			routeModulation(fxData.modParams, 4, LFO_CHANNEL);
+		};
+	}
+
+	juce::Array<BenchmarkCase> createCases()
+	{
+		using namespace customDsp;
+		juce::Array<BenchmarkCase> cases;
+
+		cases.add({ "InterpolationOsc", 1,
+			[] { return makeData<InterpolationOsc::SharedData>([](auto& data) {
+				data.wtPos = 0.5f;
+				}); },
+			[](Processor::SharedData& data) {
+				// the env slot needs an envelope channel, wt position and pitch follow the lfo
+				routeModulation(static_cast<InterpolationOsc::SharedData&>(data).modParams, 3, ENV_CHANNEL);
+			} });
+		for (auto quality : { InterpolationQuality::HERMITE, InterpolationQuality::LAGRANGE }) {
+			cases.add({ "InterpolationOsc" + INTERPOLATION_QUALITY_NAMES[(int)quality], 1,
+				[quality] { return makeData<InterpolationOsc::SharedData>([quality](auto& data) {
+					data.wtPos = 0.5f;
+					data.quality = quality;
+					}); },
+				[](Processor::SharedData& data) {
+					routeModulation(static_cast<InterpolationOsc::SharedData&>(data).modParams, 3, ENV_CHANNEL);
+				} });
+		}
+		// 1 is the single voice path, 4 the common sse/neon width, BATCH_SIZE a full register
+		juce::Array<int> batchSizes;
+		for (auto batchVoices : { 1, 4, InterpolationOsc::BATCH_SIZE }) {
+			if (batchVoices <= InterpolationOsc::BATCH_SIZE) {
+				batchSizes.addIfNotAlreadyThere(batchVoices);
+			}
+		}
+		for (auto batchVoices : batchSizes) {
+			cases.add({ "InterpolationOscBatch" + juce::String(batchVoices), 1,
+				[] { return makeData<InterpolationOsc::SharedData>([](auto& data) {
+					data.wtPos = 0.5f;
+					}); },
+				[](Processor::SharedData& data) {
+					routeModulation(static_cast<InterpolationOsc::SharedData&>(data).modParams, 3, ENV_CHANNEL);
+				},
+				batchVoices });
+		}
+		cases.add({ "Gain", 1,
+			[] { return makeData<Gain::SharedData>(); },
+			[](Processor::SharedData& data) {
+				routeModulation(static_cast<Gain::SharedData&>(data).modParams, 1, LFO_CHANNEL);
+			} });
+		cases.add({ "Pan", 2,
+			[] { return makeData<Pan::SharedData>(); },
+			[](Processor::SharedData& data) {
+				routeModulation(static_cast<Pan::SharedData&>(data).modParams, 1, LFO_CHANNEL);
+			} });
+		cases.add({ "TPTFilter", 1,
+			[] { return makeData<FilterChooser::SharedData>([](auto& data) {
+				data.filterType = FilterType::TPT_LPF12;
+				}); },
+			[](Processor::SharedData& data) {
+				routeModulation(static_cast<FilterChooser::SharedData&>(data).modParams, 3, LFO_CHANNEL);
+			} });
+		cases.add({ "Envelope", 1,
+			[] { return makeData<Envelope::SharedData>(); },
+			nullptr });
+		cases.add({ "LFO", 1,
+			[] { return makeData<LFO::SharedData>(); },
+			nullptr });
+		cases.add({ "Reverb", 2, [] { return makeFxData(FXType::REVERB); }, fxModulation() });
+		cases.add({ "Delay", 2, [] { return makeFxData(FXType::DELAY); }, fxModulation() });
+		cases.add({ "Flanger", 2, [] { return makeFxData(FXType::FLANGER); }, fxModulation() });
+		cases.add({ "Chorus", 2, [] { return makeFxData(FXType::CHORUS); }, fxModulation() });
+		cases.add({ "Phaser", 2, [] { return makeFxData(FXType::PHASER); }, fxModulation() });
+		cases.add({ "Distortion", 2, [] { return makeFxData(FXType::DISTORTION); }, fxModulation() });
+
+		return cases;
+	}
+
+	// envelopes at a constant level, lfos as slow sines and the empty channel at zero
+	void fillModBlock(juce::dsp::AudioBlock<float>& modBlock, double sampleRate)
+	{
+		modBlock.clear();
+		for (size_t channel = 0; channel < (size_t)configuration::EMPTY_MOD_CHANNEL; channel++) {
+			auto* ptr = modBlock.getChannelPointer(channel);
+			for (size_t i = 0; i < modBlock.getNumSamples(); i++) {
+				ptr[i] = (int)channel < configuration::ENV_NUMBER ? 0.8f
+					: std::sin(juce::MathConstants<float>::twoPi * 2.f * (float)((double)i / sampleRate));
+			}
+		}
+	}
+
+	double measure(const BenchmarkCase& benchmarkCase, int blockSize, double sampleRate, bool modulated, double seconds)
+	{
+		auto data = benchmarkCase.createData();
+		// wavetables are generated per sample rate
+		auto* cache = wavetable::WavetableCache::getInstance();
+		if (auto* oscData = dynamic_cast<customDsp::InterpolationOsc::SharedData*>(data.get())) {
+			oscData->wt = cache->getWavetable(0, sampleRate);
+		}
+		if (auto* lfoData = dynamic_cast<customDsp::LFO::SharedData*>(data.get())) {
+			lfoData->wt = cache->getWavetable(0, sampleRate, wavetable::MipLevels::LOWEST_ONLY);
+		}
+		if (modulated) {
+			benchmarkCase.addModulation(*data);
+		}
+		std::unique_ptr<customDsp::Processor> processor{ data->createProcessor() };
+
+		juce::dsp::ProcessSpec spec{ sampleRate, (juce::uint32)blockSize, (juce::uint32)benchmarkCase.numChannels };
+		processor->prepare(spec);
+		if (auto* osc = dynamic_cast<customDsp::InterpolationOsc*>(processor.get())) {
+			osc->setFrequency(440.f);
+			osc->setVelocity(1.f);
+		}
+		processor->noteOn();
+
+		juce::HeapBlock<char> modHeap, outputHeap, sourceHeap, workHeap;
+		juce::dsp::AudioBlock<float> modBlock{ modHeap, (size_t)configuration::EMPTY_MOD_CHANNEL + 1, (size_t)blockSize };
+		juce::dsp::AudioBlock<float> outputBlock{ outputHeap, (size_t)benchmarkCase.numChannels, (size_t)blockSize };
+		juce::dsp::AudioBlock<float> sourceBlock{ sourceHeap, (size_t)benchmarkCase.numChannels, (size_t)blockSize };
+		juce::dsp::AudioBlock<float> workBuffers{ workHeap, (size_t)customDsp::WORK_BUFFERS, (size_t)blockSize };
+		fillModBlock(modBlock, sampleRate);
+
+		juce::Random random{ 1 };
+		for (size_t channel = 0; channel < sourceBlock.getNumChannels(); channel++) {
+			for (size_t i = 0; i < sourceBlock.getNumSamples(); i++) {
+				sourceBlock.setSample((int)channel, (int)i, random.nextFloat() * 2.f - 1.f);
+			}
+		}
+
+		// modulation processors don't read any input
+		auto isModulationProcessor = dynamic_cast<customDsp::Envelope*>(processor.get()) != nullptr
+			|| dynamic_cast<customDsp::LFO*>(processor.get()) != nullptr;
+		juce::dsp::ProcessContextNonReplacing<float> context{
+			isModulationProcessor ? juce::dsp::AudioBlock<float>{} : modBlock, outputBlock };
+
+		const int numBlocks = juce::jmax(1, (int)(seconds * sampleRate) / blockSize);
+		const int warmUpBlocks = juce::jmax(1, numBlocks / 10);
+		juce::int64 ticks = 0;
+
+		for (int block = -warmUpBlocks; block < numBlocks; block++) {
+			// refilling the output is not part of the measurement
+			if (isModulationProcessor || dynamic_cast<customDsp::InterpolationOsc*>(processor.get()) != nullptr) {
+				outputBlock.clear();
+			}
+			else {
+				outputBlock.copyFrom(sourceBlock);
+			}
+			const auto start = juce::Time::getHighResolutionTicks();
+			processor->process(context, workBuffers);
+			if (block >= 0) {
+				ticks += juce::Time::getHighResolutionTicks() - start;
+			}
+		}
+
+		return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e9 / ((double)numBlocks * blockSize);
+	}
+
+	double measureBatch(const BenchmarkCase& benchmarkCase, int blockSize, double sampleRate, bool modulated, double seconds)
+	{
+		using customDsp::InterpolationOsc;
+		const auto numVoices = benchmarkCase.batchVoices;
+		jassert(0 < numVoices && numVoices <= InterpolationOsc::BATCH_SIZE);
+
+		auto data = benchmarkCase.createData();
+		auto& oscData = static_cast<InterpolationOsc::SharedData&>(*data);
+		oscData.wt = wavetable::WavetableCache::getInstance()->getWavetable(0, sampleRate);
+		if (modulated) {
+			benchmarkCase.addModulation(*data);
+		}
+
+		juce::HeapBlock<char> modHeap;
+		juce::dsp::AudioBlock<float> modBlock{ modHeap, (size_t)configuration::EMPTY_MOD_CHANNEL + 1, (size_t)blockSize };
+		fillModBlock(modBlock, sampleRate);
+
+		// every voice gets its own osc and buffers, like in Synth::runJob
+		juce::dsp::ProcessSpec spec{ sampleRate, (juce::uint32)blockSize, (juce::uint32)benchmarkCase.numChannels };
+		std::unique_ptr<InterpolationOsc> oscs[InterpolationOsc::BATCH_SIZE];
+		juce::HeapBlock<char> outputHeaps[InterpolationOsc::BATCH_SIZE], workHeaps[InterpolationOsc::BATCH_SIZE];
+		InterpolationOsc::BatchItem items[InterpolationOsc::BATCH_SIZE];
+		for (int voice = 0; voice < numVoices; voice++) {
+			oscs[voice].reset(oscData.createProcessor());
+			oscs[voice]->prepare(spec);
+			// slightly detuned, so the lanes don't read the same samples
+			oscs[voice]->setFrequency(440.f * (1.f + 0.01f * (float)voice));
+			oscs[voice]->setVelocity(1.f);
+			oscs[voice]->noteOn();
+			items[voice].osc = oscs[voice].get();
+			items[voice].inputBlock = modBlock;
+			items[voice].outputBlock = { outputHeaps[voice], (size_t)benchmarkCase.numChannels, (size_t)blockSize };
+			items[voice].workBuffers = { workHeaps[voice], (size_t)customDsp::WORK_BUFFERS, (size_t)blockSize };
+		}
+
+		const int numBlocks = juce::jmax(1, (int)(seconds * sampleRate) / blockSize);
+		const int warmUpBlocks = juce::jmax(1, numBlocks / 10);
+		juce::int64 ticks = 0;
+
+		for (int block = -warmUpBlocks; block < numBlocks; block++) {
+			for (int voice = 0; voice < numVoices; voice++) {
+				items[voice].outputBlock.clear();
+			}
+			const auto start = juce::Time::getHighResolutionTicks();
+			InterpolationOsc::processBatch(items, numVoices);
+			if (block >= 0) {
+				ticks += juce::Time::getHighResolutionTicks() - start;
+			}
+		}
+
+		return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e9 / ((double)numBlocks * blockSize * numVoices);
+	}
+
+	juce::String toCsv(const juce::Array<Result>& results)
+	{
+		juce::String csv{ "processor,block_size,sample_rate,modulation,ns_per_sample\n" };
+		for (auto& result : results) {
+			csv << result.name << "," << result.blockSize << "," << result.sampleRate << ","
+				<< (result.modulated ? 1 : 0) << "," << juce::String(result.nsPerSample, 3) << "\n";
+		}
+		return csv;
+	}
+
+	juce::String toJson(const juce::Array<Result>& results)
+	{
+		juce::Array<juce::var> entries;
+		for (auto& result : results) {
+			auto* entry = new juce::DynamicObject();
+			entry->setProperty("processor", result.name);
+			entry->setProperty("block_size", result.blockSize);
+			entry->setProperty("sample_rate", result.sampleRate);
+			entry->setProperty("modulation", result.modulated);
+			entry->setProperty("ns_per_sample", result.nsPerSample);
+			entries.add(juce::var(entry));
+		}
+		return juce::JSON::toString(juce::var(entries));
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	juce::ScopedJuceInitialiser_GUI juceInitialiser;
+	juce::ScopedNoDenormals noDenormals;
+	juce::ArgumentList args{ argc, argv };
+
+	const auto seconds = args.containsOption("--seconds") ? args.getValueForOption("--seconds").getDoubleValue() : 2.0;
+	if (seconds <= 0.0) {
+		std::cerr << "usage: Benchmark [--json] [--out <file>] [--seconds <audio seconds per measurement>]" << std::endl;
+		return 1;
+	}
+
+	juce::Array<Result> results;
+	for (auto& benchmarkCase : createCases()) {
+		for (auto sampleRate : SAMPLE_RATES) {
+			for (auto blockSize : BLOCK_SIZES) {
+				for (auto modulated : { false, true }) {
+					if (modulated && benchmarkCase.addModulation == nullptr) {
+						continue;
+					}
+					auto nsPerSample = benchmarkCase.batchVoices > 0
+						? measureBatch(benchmarkCase, blockSize, sampleRate, modulated, seconds)
+						: measure(benchmarkCase, blockSize, sampleRate, modulated, seconds);
+					results.add({ benchmarkCase.name, blockSize, sampleRate, modulated, nsPerSample });
+				}
+			}
+		}
+		std::cerr << benchmarkCase.name << " done" << std::endl;
+	}
+
+	auto output = args.containsOption("--json") ? toJson(results) : toCsv(results);
+	if (args.containsOption("--out")) {
+		if (!args.getFileForOption("--out").replaceWithText(output)) {
+			std::cerr << "couldn't write " << args.getFileForOption("--out").getFullPathName() << std::endl;
+			return 1;
+		}
+	}
+	else {
+		std::cout << output;
+	}
+	return 0;
+}
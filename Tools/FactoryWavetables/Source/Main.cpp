@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+	Generates the default wavetables for the common sample rates and writes them compressed as
+	Source/FactoryWavetableData.inc, which gets linked into the plugin through Source/FactoryWavetables.cpp.
+	The tables come straight from the generators, never from the factory data or another running instance.
+	Every entry records the generator and layout version, the plugin ignores entries of other versions.
+	The file is only rewritten when its content changes, so the tool can run before every build.
+
+	usage: FactoryWavetables --out <FactoryWavetableData.inc> [--rates <Hz,Hz,...>]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/SharedWavetableStore.h"
+
+namespace {
+
+	const juce::String DEFAULT_RATES{ "44100,48000" };
+
+	juce::MemoryBlock compress(const juce::MemoryBlock& data)
+	{
+		juce::MemoryOutputStream compressed;
+		{
+			// flushes when it goes out of scope
+			juce::GZIPCompressorOutputStream stream{ compressed, 9 };
+			stream.write(data.getData(), data.getSize());
+		}
+		return compressed.getMemoryBlock();
+	}
+
+	void writeArray(juce::OutputStream& out, const juce::String& identifier, const juce::MemoryBlock& data)
+	{
+		out << "\tstatic const unsigned char " << identifier << "[]{";
+		auto* bytes = static_cast<const unsigned char*>(data.getData());
+		for (size_t i = 0; i < data.getSize(); i++) {
+			if (i % 32 == 0) {
+				out << "\n\t\t";
+			}
+			out << (int)bytes[i] << ",";
+		}
+		out << "\n\t};\n\n";
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	juce::ScopedJuceInitialiser_GUI juceInitialiser;
+	juce::ArgumentList args{ argc, argv };
+
+	juce::Array<double> sampleRates;
+	auto rates = args.containsOption("--rates") ? args.getValueForOption("--rates") : DEFAULT_RATES;
+	for (auto& rate : juce::StringArray::fromTokens(rates, ",", "")) {
+		sampleRates.add(rate.getDoubleValue());
+	}
+	if (!args.containsOption("--out") || sampleRates.isEmpty() || sampleRates.contains(0.0)) {
+		std::cerr << "usage: FactoryWavetables --out <FactoryWavetableData.inc> [--rates <Hz,Hz,...>]" << std::endl;
+		return 1;
+	}
+
+	juce::MemoryOutputStream code;
+	code << "// written by Tools/FactoryWavetables, don't edit\n\n";
+	juce::String entries;
+	int index = 0;
+
+	auto* cache = wavetable::WavetableCache::getInstance();
+	auto& names = cache->getGeneratableWavetableNames();
+	for (int nameIndex = 0; nameIndex < names.size(); nameIndex++) {
+		auto& name = names[nameIndex];
+		for (auto sampleRate : sampleRates) {
+			std::unique_ptr<wavetable::Wavetable> wt{ cache->generateWavetable(nameIndex, sampleRate, wavetable::MipLevels::ALL) };
+			juce::MemoryBlock data;
+			if (wt == nullptr || !wavetable::SharedWavetableStore::toData(*wt, data)) {
+				std::cerr << "couldn't generate " << name << " for " << sampleRate << " Hz" << std::endl;
+				return 1;
+			}
+			auto compressed = compress(data);
+			auto identifier = "table" + juce::String(index++);
+			writeArray(code, identifier, compressed);
+			entries << "\t\t{ \"" << name << "\", " << juce::String(sampleRate, 1) << ", " << identifier << ", "
+				<< (int)compressed.getSize() << ", " << wavetable::SharedWavetableStore::LAYOUT_VERSION << ", "
+				<< wavetable::WavetableCache::GENERATOR_VERSION << " },\n";
+
+			std::cout << name << " at " << sampleRate << " Hz: " << data.getSize() << " bytes, "
+				<< compressed.getSize() << " compressed" << std::endl;
+		}
+	}
+	code << "\tstatic const Entry entries[]{\n" << entries << "\t};\n";
+
+	auto outputFile = args.getFileForOption("--out");
+	juce::MemoryBlock existing;
+	if (outputFile.loadFileAsData(existing) && existing.matches(code.getData(), code.getDataSize())) {
+		std::cout << outputFile.getFullPathName() << " is up to date" << std::endl;
+		return 0;
+	}
+	if (!outputFile.replaceWithData(code.getData(), code.getDataSize())) {
+		std::cerr << "couldn't write " << outputFile.getFullPathName() << std::endl;
+		return 1;
+	}
+	return 0;
+}
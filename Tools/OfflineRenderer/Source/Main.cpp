@@ -0,0 +1,181 @@
+/*
+  ==============================================================================
+
+	Renders a Standard MIDI File with a preset to a WAV file without any audio device.
+	Blocks are processed back to back, so this runs as fast as the CPU allows.
+
+	usage: OfflineRenderer --preset <file> --midi <file> --out <file.wav>
+		[--rate <Hz>] [--block <samples>] [--threads <n>] [--tail <seconds>] [--bits <16|24|32>]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+
+namespace {
+
+	struct Options {
+		juce::File presetFile;
+		juce::File midiFile;
+		juce::File outputFile;
+		double sampleRate = 48000.0;
+		int blockSize = 512;
+		// render threads don't come from the preset or the machine settings, so a render is the same everywhere
+		int numThreads = 1;
+		double tailSeconds = 2.0;
+		int bitsPerSample = 24;
+	};
+
+	void printUsage()
+	{
+		std::cout << "usage: OfflineRenderer --preset <file> --midi <file> --out <file.wav>" << std::endl
+			<< "\t[--rate <Hz>] [--block <samples>] [--threads <n>] [--tail <seconds>] [--bits <16|24|32>]" << std::endl;
+	}
+
+	bool parseOptions(const juce::ArgumentList& args, Options& options)
+	{
+		if (!args.containsOption("--preset") || !args.containsOption("--midi") || !args.containsOption("--out")) {
+			return false;
+		}
+		options.presetFile = args.getExistingFileForOption("--preset");
+		options.midiFile = args.getExistingFileForOption("--midi");
+		options.outputFile = args.getFileForOption("--out");
+
+		if (args.containsOption("--rate")) {
+			options.sampleRate = args.getValueForOption("--rate").getDoubleValue();
+		}
+		if (args.containsOption("--block")) {
+			options.blockSize = args.getValueForOption("--block").getIntValue();
+		}
+		if (args.containsOption("--threads")) {
+			options.numThreads = args.getValueForOption("--threads").getIntValue();
+		}
+		if (args.containsOption("--tail")) {
+			options.tailSeconds = args.getValueForOption("--tail").getDoubleValue();
+		}
+		if (args.containsOption("--bits")) {
+			options.bitsPerSample = args.getValueForOption("--bits").getIntValue();
+		}
+		return options.sampleRate > 0.0 && options.blockSize > 0 && options.numThreads > 0 && options.tailSeconds >= 0.0;
+	}
+
+	// presets saved by the plugin are binary blobs, hand written xml files are accepted as well
+	bool loadPreset(SynthAudioProcessor& processor, const juce::File& file)
+	{
+		juce::MemoryBlock data;
+		if (!file.loadFileAsData(data)) {
+			return false;
+		}
+		if (auto xml = juce::parseXML(data.toString())) {
+			data.reset();
+			juce::AudioProcessor::copyXmlToBinary(*xml, data);
+		}
+		processor.setStateInformation(data.getData(), (int)data.getSize());
+		return true;
+	}
+
+	// all tracks merged into one sequence with timestamps in seconds
+	bool loadMidi(const juce::File& file, juce::MidiMessageSequence& sequence)
+	{
+		juce::FileInputStream stream{ file };
+		juce::MidiFile midiFile;
+		if (!stream.openedOk() || !midiFile.readFrom(stream)) {
+			return false;
+		}
+		midiFile.convertTimestampTicksToSeconds();
+		for (int track = 0; track < midiFile.getNumTracks(); track++) {
+			sequence.addSequence(*midiFile.getTrack(track), 0.0);
+		}
+		sequence.updateMatchedPairs();
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	juce::ScopedJuceInitialiser_GUI juceInitialiser;
+	juce::ArgumentList args{ argc, argv };
+
+	Options options;
+	if (!parseOptions(args, options)) {
+		printUsage();
+		return 1;
+	}
+
+	juce::MidiMessageSequence sequence;
+	if (!loadMidi(options.midiFile, sequence)) {
+		std::cerr << "couldn't read midi file " << options.midiFile.getFullPathName() << std::endl;
+		return 1;
+	}
+
+	SynthAudioProcessor processor;
+	if (!loadPreset(processor, options.presetFile)) {
+		std::cerr << "couldn't read preset " << options.presetFile.getFullPathName() << std::endl;
+		return 1;
+	}
+	processor.setNumRenderThreads(options.numThreads);
+
+	const int numChannels = processor.getTotalNumOutputChannels();
+	processor.setNonRealtime(true);
+	processor.setPlayConfigDetails(0, numChannels, options.sampleRate, options.blockSize);
+	processor.prepareToPlay(options.sampleRate, options.blockSize);
+
+	options.outputFile.deleteFile();
+	std::unique_ptr<juce::FileOutputStream> outputStream{ options.outputFile.createOutputStream() };
+	if (outputStream == nullptr) {
+		std::cerr << "couldn't create " << options.outputFile.getFullPathName() << std::endl;
+		return 1;
+	}
+	juce::WavAudioFormat wavFormat;
+	std::unique_ptr<juce::AudioFormatWriter> writer{ wavFormat.createWriterFor(outputStream.get(),
+		options.sampleRate, (unsigned int)numChannels, options.bitsPerSample, {}, 0) };
+	if (writer == nullptr) {
+		std::cerr << "unsupported output format" << std::endl;
+		return 1;
+	}
+	// the writer owns the stream from now on
+	outputStream.release();
+
+	const auto totalSamples = (juce::int64)std::ceil((sequence.getEndTime() + options.tailSeconds) * options.sampleRate);
+
+	juce::AudioBuffer<float> buffer{ numChannels, options.blockSize };
+	juce::MidiBuffer midiBuffer;
+	int nextEvent = 0;
+	double renderSeconds = 0.0;
+
+	for (juce::int64 blockStart = 0; blockStart < totalSamples; blockStart += options.blockSize) {
+		const int numSamples = (int)juce::jmin((juce::int64)options.blockSize, totalSamples - blockStart);
+		const auto blockEnd = blockStart + numSamples;
+
+		midiBuffer.clear();
+		for (; nextEvent < sequence.getNumEvents(); nextEvent++) {
+			const auto& message = sequence.getEventPointer(nextEvent)->message;
+			const auto samplePos = juce::roundToInt(message.getTimeStamp() * options.sampleRate);
+			if (samplePos >= blockEnd) {
+				break;
+			}
+			if (!message.isMetaEvent()) {
+				midiBuffer.addEvent(message, juce::jmax(0, (int)(samplePos - blockStart)));
+			}
+		}
+
+		// only the engine is timed, file io isn't part of the real time factor
+		buffer.setSize(numChannels, numSamples, false, false, true);
+		const auto start = juce::Time::getHighResolutionTicks();
+		processor.processBlock(buffer, midiBuffer);
+		renderSeconds += juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+		writer->writeFromAudioSampleBuffer(buffer, 0, numSamples);
+	}
+
+	writer.reset();
+	processor.releaseResources();
+
+	const auto audioSeconds = (double)totalSamples / options.sampleRate;
+	std::cout << "rendered " << audioSeconds << " s of audio in " << renderSeconds << " s" << std::endl
+		<< "sample rate " << options.sampleRate << " Hz, block size " << options.blockSize
+		<< ", render threads " << processor.getNumRenderThreads() << std::endl
+		<< "real time factor " << (renderSeconds > 0.0 ? audioSeconds / renderSeconds : 0.0) << "x" << std::endl;
+	return 0;
+}
@@ -0,0 +1,183 @@
+/*
+  ==============================================================================
+
+	Converts wav files to .wt files. A file is either a single cycle of any length or a sequence of frames
+	of --frame samples each, every frame becomes one wavetable position. All files are converted in parallel.
+	With --compress the tables are stored losslessly compressed, which makes them smaller but they're decoded when loading.
+
+	usage: WavetableConverter --out <folder> [--frame <samples>] [--rate <Hz>] [--threads <n>] [--compress] <wav files or folders>
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/Wavetable.h"
+
+namespace {
+
+	struct Options {
+		juce::File outputFolder;
+		int frameSize = 2048;
+		// tables are band limited for this rate, since files are used at every rate
+		double sampleRate = 44100.0;
+		int numThreads = juce::SystemStats::getNumCpus();
+		wavetable::Wavetable::FileCodec codec = wavetable::Wavetable::FileCodec::RAW;
+		juce::Array<juce::File> inputFiles;
+	};
+
+	void printUsage()
+	{
+		std::cout << "usage: WavetableConverter --out <folder> [--frame <samples>] [--rate <Hz>] [--threads <n>]"
+			<< " [--compress] <wav files or folders>" << std::endl;
+	}
+
+	bool parseOptions(const juce::ArgumentList& args, Options& options)
+	{
+		if (!args.containsOption("--out")) {
+			return false;
+		}
+		options.outputFolder = args.getFileForOption("--out");
+		if (args.containsOption("--frame")) {
+			options.frameSize = args.getValueForOption("--frame").getIntValue();
+		}
+		if (args.containsOption("--rate")) {
+			options.sampleRate = args.getValueForOption("--rate").getDoubleValue();
+		}
+		if (args.containsOption("--threads")) {
+			options.numThreads = args.getValueForOption("--threads").getIntValue();
+		}
+		if (args.containsOption("--compress")) {
+			options.codec = wavetable::Wavetable::FileCodec::COMPRESSED;
+		}
+
+		// everything which isn't an option or its value is an input
+		for (int i = 0; i < args.size(); i++) {
+			auto& argument = args[i];
+			if (argument.isLongOption()) {
+				// --compress is the only option without a value
+				if (!argument.text.contains("=") && argument != "--compress") {
+					i++;
+				}
+				continue;
+			}
+			auto file = argument.resolveAsFile();
+			if (file.isDirectory()) {
+				options.inputFiles.addArray(file.findChildFiles(juce::File::findFiles, true, "*.wav"));
+			}
+			else {
+				options.inputFiles.add(file);
+			}
+		}
+		return options.frameSize >= 4 && juce::isPowerOfTwo(options.frameSize) && options.sampleRate > 0.0
+			&& options.numThreads > 0 && !options.inputFiles.isEmpty();
+	}
+
+	// one cycle of any length, stretched to frameSize samples
+	void resampleCycle(const float* source, int sourceSize, float* dest, int frameSize)
+	{
+		for (int i = 0; i < frameSize; i++) {
+			auto position = (double)i * sourceSize / frameSize;
+			auto index = static_cast<int>(position);
+			auto delta = static_cast<float>(position - index);
+			dest[i] = juce::jmap(delta, source[index], source[(index + 1) % sourceSize]);
+		}
+	}
+
+	// empty if the file was converted, otherwise what went wrong
+	juce::String convert(const juce::File& inputFile, const Options& options)
+	{
+		juce::AudioFormatManager formatManager;
+		formatManager.registerBasicFormats();
+		std::unique_ptr<juce::AudioFormatReader> reader{ formatManager.createReaderFor(inputFile) };
+		if (reader == nullptr) {
+			return "couldn't read the file";
+		}
+		const auto numSamples = (int)reader->lengthInSamples;
+		if (numSamples < 2) {
+			return "the file is empty";
+		}
+
+		// all channels mixed down to mono
+		juce::AudioBuffer<float> audio{ (int)reader->numChannels, numSamples };
+		reader->read(audio.getArrayOfWritePointers(), audio.getNumChannels(), 0, numSamples);
+		for (int channel = 1; channel < audio.getNumChannels(); channel++) {
+			audio.addFrom(0, 0, audio, channel, 0, numSamples);
+		}
+		audio.applyGain(0, 0, numSamples, 1.f / (float)audio.getNumChannels());
+
+		const auto* samples = audio.getReadPointer(0);
+		auto numFrames = numSamples / options.frameSize;
+		juce::AudioBuffer<float> frames;
+		if (numSamples % options.frameSize != 0 && numFrames <= 1) {
+			frames.setSize(1, options.frameSize);
+			resampleCycle(samples, numSamples, frames.getWritePointer(0), options.frameSize);
+		}
+		else {
+			// a partial frame at the end is dropped
+			frames.setSize(numFrames, options.frameSize);
+			for (int frame = 0; frame < numFrames; frame++) {
+				frames.copyFrom(frame, 0, samples + frame * options.frameSize, options.frameSize);
+			}
+		}
+
+		auto name = inputFile.getFileNameWithoutExtension();
+		wavetable::FrameWavetable wt{ name, frames, options.sampleRate };
+		juce::MemoryBlock data;
+		wt.toMemoryBlock(data, options.codec);
+		auto outputFile = options.outputFolder.getChildFile(name + configuration::WT_FILE_EXTENSION);
+		if (!outputFile.replaceWithData(data.getData(), data.getSize())) {
+			return "couldn't write " + outputFile.getFullPathName();
+		}
+		// the plugin only checks the level crcs of compressed files, so raw files are checked once here
+		juce::MemoryBlock written;
+		if (!outputFile.loadFileAsData(written) || !wavetable::Wavetable::isValidFileData(written.getData(), written.getSize())
+			|| !wavetable::Wavetable::verifyLevelCrcs(written.getData(), written.getSize())) {
+			return "the written file " + outputFile.getFullPathName() + " is damaged";
+		}
+		return {};
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	juce::ScopedJuceInitialiser_GUI juceInitialiser;
+	juce::ArgumentList args{ argc, argv };
+
+	Options options;
+	if (!parseOptions(args, options)) {
+		printUsage();
+		return 1;
+	}
+	if (!options.outputFolder.createDirectory()) {
+		std::cerr << "couldn't create " << options.outputFolder.getFullPathName() << std::endl;
+		return 1;
+	}
+
+	juce::CriticalSection outputLock;
+	std::atomic<int> numFailed{ 0 };
+	const auto start = juce::Time::getMillisecondCounterHiRes();
+	{
+		juce::ThreadPool pool{ options.numThreads };
+		for (auto& inputFile : options.inputFiles) {
+			pool.addJob([&options, &outputLock, &numFailed, inputFile] {
+				auto error = convert(inputFile, options);
+				const juce::ScopedLock sl(outputLock);
+				if (error.isEmpty()) {
+					std::cout << inputFile.getFileName() << std::endl;
+				}
+				else {
+					std::cerr << inputFile.getFullPathName() << ": " << error << std::endl;
+					numFailed++;
+				}
+			});
+		}
+		// the pool would drop the jobs which haven't started yet when it gets destroyed
+		while (pool.getNumJobs() > 0) {
+			juce::Thread::sleep(10);
+		}
+	}
+
+	std::cout << "converted " << options.inputFiles.size() - numFailed << " of " << options.inputFiles.size()
+		<< " files in " << (juce::Time::getMillisecondCounterHiRes() - start) / 1000.0 << " s" << std::endl;
+	return numFailed == 0 ? 0 : 1;
+}